@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "PuzzleGenerator.h"
+#include "BoundedQueue.h"
+#include "Canonical.h"
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+
+struct GeneratorOptions
+{
+	int BoxN = 3;
+	long long count = 1;
+	int MinClues = 0, MaxClues = 81;
+	Difficulty MinDifficulty = Difficulty::Easy, MaxDifficulty = Difficulty::Expert;
+	Symmetry symmetry = Symmetry::None;
+	uint64_t seed = 0;
+	int threads = 1;
+
+	// drops puzzles equivalent to an earlier one (9 * 9 only).
+	bool deduplicate = false;
+
+	// capacity of each queue between two stages.
+	int QueueSize = 64;
+
+	// gives up after this many candidates (0 = never), for bands that can't be reached.
+	long long MaxCandidates = 0;
+};
+
+// one candidate on its way through the pipeline.
+struct GeneratedPuzzle
+{
+	long long index;
+	uint64_t seed;
+	Grid puzzle, solution;
+	int clues;
+	Difficulty difficulty;
+	uint64_t hash;				// canonical hash, only with deduplicate.
+	bool accepted;
+};
+
+// generates puzzles in three stages: full grid, clue removal, grading.
+// RemoveClues only keeps a removal that leaves the puzzle unique, so no stage checks it again.
+// every stage has its own workers and they are connected by bounded queues.
+// every candidate gets a seed made from its index only, and the results are written
+// in the order of the candidates, so the output doesn't depend on the threads.
+class BatchGenerator
+{
+	GeneratorOptions options;
+
+	std::atomic<bool> stop;
+
+	// candidates are only started while less than Window of them are unfinished,
+	// which bounds the reordering buffer.
+	std::mutex WindowMutex;
+	std::condition_variable WindowChanged;
+	long long next, finished, Window;
+
+	bool Take(long long& index);
+	void Finish();
+
+	// runs f on every item of in and passes it to out, the last worker to leave closes out.
+	void RunStage(BoundedQueue<GeneratedPuzzle>& in, BoundedQueue<GeneratedPuzzle>& out,
+				  std::atomic<int>& alive, std::function<void(PuzzleGenerator&, GeneratedPuzzle&)> f);
+
+public:
+
+	// number of candidates that went through the pipeline in the last run.
+	long long NumberOfCandidates;
+
+	BatchGenerator(const GeneratorOptions& options);
+
+	// calls output for each accepted puzzle in order, returns the number of puzzles.
+	long long Run(std::function<void(const GeneratedPuzzle&)> output);
+};
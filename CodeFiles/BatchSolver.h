@@ -0,0 +1,110 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include "ThreadPool.h"
+#include "SolverStats.h"
+#include "Metrics.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+
+class SolutionCache;
+
+// Sudoku is SudokuSolver (up to 25 * 25), Bitmask is MaskSolver, Bitboard is BitboardSolver
+// (classic 9 * 9 only). other sizes and variants are solved by MaskSolver.
+enum class Engine { Sudoku, Bitmask, Bitboard };
+
+// "sudoku", "mask" or "bitboard", as the command line tools take it.
+bool ParseEngine(const std::string& name, Engine& engine);
+
+// Invalid is a puzzle whose clues contradict each other (a number twice in a unit, or out of range)
+// or that has no board, Unsolvable one that has no solution, whether a search or the propagation
+// of the clues finds it, the same with every engine. TimedOut only comes from SudokuSolver, with a time limit.
+enum class SolveStatus { Solved, Unsolvable, Invalid, TimedOut };
+
+struct SolveResult
+{
+	SolveStatus status = SolveStatus::Invalid;
+	Grid solution;								// the puzzle itself unless solved.
+	long long nodes = 0;						// search nodes, 0 if the solution came from the cache.
+	double seconds = 0;
+	bool cached = false;
+};
+
+// solves many puzzles at once on a ThreadPool.
+// every worker keeps its own solvers for as long as the BatchSolver lives, so a batch
+// allocates nothing but the grids of results that are too small.
+class BatchSolver
+{
+	struct Worker;
+
+	ThreadPool pool;
+	std::vector<std::unique_ptr<Worker>> workers;
+	Engine engine;
+	SolutionCache* cache;
+	bool lanes;
+	uint64_t seed;
+	std::string variant;
+	bool classic;									// variant has only rows, columns and boxes.
+
+public:
+
+	// 0 threads means one per core.
+	BatchSolver(int threads = 0, Engine engine = Engine::Sudoku);
+	~BatchSolver();
+
+	int Threads() const { return pool.Size(); }
+
+	void SetEngine(Engine engine) { this->engine = engine; }
+
+	// 9 * 9 puzzles are looked up in cache first and added to it when solved, nullptr for none.
+	void SetCache(SolutionCache* cache) { this->cache = cache; }
+
+	// 9 * 9 puzzles are first propagated in groups of LaneSolver::Lanes, and only the ones
+	// that need a search go to the engine (and the cache), false by default.
+	// worth it when most puzzles are easy, a group costs about as much as one search.
+	void SetLanes(bool lanes) { this->lanes = lanes; }
+
+	// the puzzles are of a variant, see UnitGraph::Parse. a puzzle of a size the variant has no board of
+	// (a jigsaw of another size) is Invalid. the cache and the lanes are only used for classic puzzles.
+	// false (and nothing changes) if it isn't a variant of any size, "" (the default) is classic.
+	bool SetVariant(const std::string& variant);
+
+	// SudokuSolver picks its guesses at random, with a seed puzzles[i] is solved with seed + i,
+	// so the nodes of a batch are the same every time and with any number of threads.
+	// 0 (the default) keeps the random seeds.
+	void SetSeed(uint64_t seed) { this->seed = seed; }
+
+	// a SudokuSolver search that takes longer than seconds is stopped and TimedOut, 0 (the default) for none.
+	// the clock is looked at every SudokuSolver::ProgressInterval nodes, so a search may run a little over.
+	// the other engines aren't limited.
+	void SetTimeLimit(double seconds);
+
+	// the stats of every solve since the last ResetStats, added up over the workers.
+	// SudokuSolver fills all of them, the other engines the solves, nodes, times and the singles
+	// (and locked candidates) they propagated, and the time of the lanes is propagate. puzzles found in the cache aren't counted.
+	// neither may be called during SolveBatch.
+	SolverStats Stats() const;
+	void ResetStats();
+
+	// adds the latencies and results of every puzzle since the last ResetMetrics to total.
+	// unlike Stats it may be called at any time, from any thread, while batches are solved.
+	// ResetMetrics may not be called during SolveBatch.
+	void Metrics(SolveMetrics& total) const;
+	void ResetMetrics();
+
+	// solves puzzles[i] into results[i] for i in [0, count).
+	// the size of a puzzle comes from its number of cells, puzzles of different sizes can be mixed.
+	void SolveBatch(const Grid* puzzles, size_t count, SolveResult* results);
+	void SolveBatch(const std::vector<Grid>& puzzles, std::vector<SolveResult>& results);
+
+	// solves count chunks of puzzles, a chunk is one task so the puzzles are also read and written on the workers.
+	// read(c, puzzles) puts the puzzles of chunk c at the front of puzzles (growing it if needed) and returns
+	// how many, write(c, puzzles, results, n) gets them back with their results. both are called on the worker
+	// that took the chunk, and the grids are reused for its next chunk.
+	// with a seed, puzzle i of chunk c is solved with seed + (c << 32) + i.
+	void SolveChunks(size_t count, const std::function<size_t(size_t, std::vector<Grid>&)>& read,
+					 const std::function<void(size_t, const Grid*, const SolveResult*, size_t)>& write);
+};
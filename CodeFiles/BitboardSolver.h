@@ -0,0 +1,80 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include "SolverStats.h"
+#include <vector>
+#include <cstdint>
+
+// a solver for 9 * 9 boards only, on digit planes.
+// the candidates are nine 81 bit planes, plane d has the cells where d + 1 can still go.
+// a plane is three 27 bit words, one per band of three rows, and two planes share one
+// 256 bit vector (bands in lanes 0..2 and 4..6), so the whole board is five vectors and
+// eliminations and the search for naked singles and empty cells touch every cell at once.
+// hidden singles are found per plane with word wide bit tricks.
+//
+// the kernel is compiled twice, for AVX2 and for the baseline instruction set,
+// and the one to use is picked at run time from the CPU.
+class BitboardSolver
+{
+public:
+
+	typedef uint32_t Vector __attribute__((vector_size(32)));
+
+	struct State
+	{
+		Vector planes[5];						// candidates, the second half of planes[4] is unused.
+		Vector placed[5];						// the same layout, the cells where each number was placed.
+		Vector unsolved;						// cells without a number, in both halves.
+	};
+
+	// one search depth, the cell being tried and the numbers left to try.
+	struct Frame
+	{
+		State state;
+		int cell;
+		uint32_t left;
+	};
+
+	typedef int (*Kernel)(Frame* stack, int limit, long long& nodes, long long* propagations, Grid& solution);
+
+private:
+
+	// the frames need 32 byte alignment, which new doesn't promise before C++17,
+	// so they live in a buffer aligned by hand: 82 search depths, then the loaded board.
+	std::vector<char> memory;
+	Frame* stack;
+	State* root;
+
+	bool loaded;
+	Grid solution;
+	Kernel kernel;
+
+public:
+
+	// number of propagations in the last call to CountSolutions.
+	long long NumberOfNodes;
+
+	// cells the last CountSolutions set by naked and hidden singles (see SolverStats).
+	long long Propagations[SolverStats::Strategies];
+
+	BitboardSolver();
+	BitboardSolver(const BitboardSolver&) = delete;
+	BitboardSolver& operator= (const BitboardSolver&) = delete;
+
+	// "avx2" or "generic".
+	static const char* KernelName();
+
+	// returns false if the board isn't 9 * 9 or has a contradiction.
+	bool Load(const Grid& grid);
+
+	// stops as soon as limit solutions are found.
+	int CountSolutions(int limit = 2);
+	bool Solve() { return CountSolutions(1) == 1; }
+	bool Unique() { return CountSolutions(2) == 1; }
+
+	const Grid& GetSolution() const { return solution; }
+
+	// the solver and its search stack on the heap.
+	size_t MemoryUsage() const { return sizeof(*this) + memory.capacity() + solution.capacity() * sizeof(int); }
+};
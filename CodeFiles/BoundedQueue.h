@@ -0,0 +1,94 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+// a blocking queue with a maximum size, used between the stages of a pipeline.
+// push waits while the queue is full and pop waits while it's empty.
+// after close, push fails and pop fails once the queue is empty.
+template <typename T>
+class BoundedQueue
+{
+	std::queue<T> q;
+	size_t capacity;
+	bool closed;
+
+	std::mutex m;
+	std::condition_variable NotEmpty, NotFull;
+
+public:
+
+	BoundedQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+	bool push(T t);
+	bool pop(T& t);
+
+	// waits for one item like pop, then also takes whatever else is queued, up to max items.
+	// items is cleared first, returns the number of items taken.
+	size_t pop(std::vector<T>& items, size_t max);
+
+	void close();
+};
+
+// ------------------------ definitions are provided in the same file to avoid some linking errors.
+
+template <typename T>
+bool BoundedQueue<T>::push(T t)
+{
+	std::unique_lock<std::mutex> lock(m);
+	NotFull.wait(lock, [this] { return closed || q.size() < capacity; });
+
+	if (closed)
+		return false;
+
+	q.push(std::move(t));
+	NotEmpty.notify_one();
+
+	return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::pop(T& t)
+{
+	std::unique_lock<std::mutex> lock(m);
+	NotEmpty.wait(lock, [this] { return closed || !q.empty(); });
+
+	if (q.empty())
+		return false;
+
+	t = std::move(q.front());
+	q.pop();
+	NotFull.notify_one();
+
+	return true;
+}
+
+template <typename T>
+size_t BoundedQueue<T>::pop(std::vector<T>& items, size_t max)
+{
+	items.clear();
+
+	std::unique_lock<std::mutex> lock(m);
+	NotEmpty.wait(lock, [this] { return closed || !q.empty(); });
+
+	while (!q.empty() && items.size() < max)
+	{
+		items.push_back(std::move(q.front()));
+		q.pop();
+	}
+
+	NotFull.notify_all();
+
+	return items.size();
+}
+
+template <typename T>
+void BoundedQueue<T>::close()
+{
+	std::lock_guard<std::mutex> lock(m);
+	closed = true;
+	NotEmpty.notify_all();
+	NotFull.notify_all();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include "SudokuTransform.h"
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// the representative of a 9 * 9 board under the whole symmetry group,
+// and the transformation that takes the board to it (transform.Apply(board) == grid).
+struct CanonicalForm
+{
+	Grid grid;
+	SudokuTransform transform;
+	uint64_t hash;
+};
+
+// computes the minlex form: the smallest board, read row by row, among all the boards
+// that SudokuTransform can make from the given one (empty cells are 0, the smallest).
+// for a fixed placement of the cells the smallest relabeling numbers the values in order
+// of first appearance, so only the placements are searched, one row at a time, keeping
+// every partial placement that ties for the smallest rows so far. placements that can
+// only go on the same way are merged, and a complete grid starts at its second row.
+// works for solved grids and puzzles alike. keeps its buffers, so reuse one per thread.
+class Canonicalizer
+{
+	// a placement of the first rows.
+	struct Partial
+	{
+		uint8_t transpose;
+		uint16_t columns;			// index into ColumnMaps.
+		uint8_t rows[9];			// rows[k] is the row that becomes row k.
+		uint8_t label[10];			// new number of each value, 0 = not seen yet.
+		uint8_t next;				// last label given.
+	};
+
+	// a column map being built for the second row of a complete grid.
+	struct Placement
+	{
+		int8_t columns[9];			// column that goes to each position, -1 = open.
+		int8_t position[9];			// position of each column, -1 = open.
+		int8_t stack[3];			// stack that goes to each block, -1 = open.
+		int8_t block[3];			// block of each stack, -1 = open.
+		uint8_t row[9];				// the second row so far.
+	};
+
+	// the 1296 column maps that keep columns in their stacks.
+	std::vector<std::array<uint8_t, 9>> ColumnMaps;
+	std::vector<Partial> current, next;
+	std::vector<std::pair<uint64_t, uint32_t>> keys;
+
+	// state of the second row search.
+	Partial base;
+	uint8_t best[9], follow[9];
+	const uint8_t* top;
+
+	static bool Complete(const uint8_t source[2][81]);
+	void SearchSecondRow(const uint8_t source[2][81]);
+	void Place(const Placement& placement, int j);
+	void Follow(Placement& placement, int j);
+	void Merge(int rows);
+
+public:
+
+	Canonicalizer();
+
+	// false if the board isn't 9 * 9.
+	bool Canonicalize(const Grid& grid, CanonicalForm& form);
+	bool Canonicalize(const Board& board, CanonicalForm& form);
+
+	// hash of the canonical form, equal for equivalent boards.
+	uint64_t Hash(const Grid& grid);
+	uint64_t Hash(const Board& board);
+
+	// 64 bit hash of a grid as it is.
+	static uint64_t HashGrid(const Grid& grid);
+};
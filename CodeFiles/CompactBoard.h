@@ -0,0 +1,54 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include <cstdint>
+#include <type_traits>
+
+// the state of a 9 * 9 SudokuBoard in 298 bytes without a pointer, where SudokuBoard keeps
+// kilobytes of sets on the heap: the cells, the candidates of every cell and the numbers of every unit.
+// SetCell, UnsetCell, AddCandidate and DeleteCandidate change it the way they change SudokuBoard,
+// and the buckets of SudokuBoard (CellsWithNCandidates) are the popcounts of the candidates.
+// it is trivially copyable and has no padding, so a search frontier or a cache can keep millions
+// in one vector, and copy, compare or hash them as bytes.
+struct CompactBoard
+{
+	static const int N = 9, Cells = 81;
+
+	uint8_t cells[Cells];									// 0 = empty.
+	uint8_t filled;											// cells that aren't empty.
+	uint16_t candidates[Cells];								// bit (num - 1), also kept for cells that are set.
+	uint16_t rows[N], columns[N], boxes[N];					// the numbers placed in each unit.
+
+	CompactBoard() { Clear(); }
+
+	void Clear();
+
+	// false if the grid isn't 9 * 9 or a clue contradicts an earlier one.
+	bool Load(const Grid& grid);
+	void GetGrid(Grid& grid) const;
+
+	bool isCandidate(int cell, int num) const { return candidates[cell] >> (num - 1) & 1; }
+	int CandidateCount(int cell) const { return __builtin_popcount(candidates[cell]); }
+
+	// false if num isn't a candidate of the empty cell, else deletes num from the cell and its peers.
+	bool SetCell(int cell, int num);
+
+	// false if the cell is empty, else adds its number back to the cell and the peers that allow it.
+	bool UnsetCell(int cell);
+
+	// the cell alone, false if nothing changed. a number placed in a unit of the cell isn't added.
+	bool AddCandidate(int cell, int num);
+	bool DeleteCandidate(int cell, int num);
+
+	bool Solved() const { return filled == Cells; }
+
+	// false if an empty cell has no candidate left.
+	bool Possible() const;
+
+	// an empty cell with the fewest candidates (the first one), -1 if there is none.
+	int NextCell() const;
+};
+
+static_assert(std::is_trivially_copyable<CompactBoard>::value, "CompactBoard is copied as bytes");
+static_assert(sizeof(CompactBoard) == 298, "CompactBoard has no padding");
@@ -1,142 +1,52 @@
 #pragma once
 
-#include <set>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
+#include <algorithm>
 #include "RNG.h"
 
-template <typename T>
-struct element
+// a set of the numbers 1..64 in one word, with the part of the std::set<int> interface
+// the board uses. it iterates in increasing order like std::set, and never allocates.
+class NumberSet
 {
-	T t;
-	mutable int idx;
-
-	element(T t, int idx = 0) : t(t), idx(idx) {};
+	uint64_t bits = 0;
 
-	bool operator< (const element& e) const
-	{
-		return t < e.t;
-	}
-
-	bool operator== (const element& e) const
-	{
-		return t == e.t;
-	}
-};
-
-template <typename T>
-class Container
-{
-	std::set<element<T>> s;
-	std::vector<T> v;
+	static uint64_t Bit(int num) { return (uint64_t)1 << (num - 1); }
 
 public:
 
-	const T& operator[](int idx) const;
-	bool insert(const T& t);
-	bool erase(const T& t);
-	bool EraseAt(int i);
-	int find(const T& t);
-	bool present(const T& t);
-    const T& GetRandom();
-	T PopRandom();
-	int size() const;
-	bool empty() const;
-	bool clear();
-};
-
-// ------------------------ definitions are provided in the same file to avoid some linking errors.
-
-template <typename T>
-bool Container<T>::erase(const T& t)
-{
-	auto it = s.find(t);
-
-	// if the element is not found or the set is empty, return false.
-	if (it == s.end())
-		return false;
-
-	auto tmp = s.find(v.back());
-	tmp->idx = it->idx;
-	std::swap(v[it->idx], v.back());
-	
-	v.pop_back();
-	s.erase(it);
-
-	return true;
-}
-
-template <typename T>
-bool Container<T>::insert(const T& t)
-{
-	bool ElementInserted = s.insert(element<T>(t, (int)v.size())).second;
-
-	if (ElementInserted)
-		v.push_back(t);
-
-	return ElementInserted;
-}
-
-template <typename T>
-const T& Container<T>::operator[](int idx) const
-{
-	return v[idx];
-}
+	// the numbers left, the current one is the lowest.
+	class iterator
+	{
+		uint64_t rest;
 
-template <typename T>
-bool Container<T>::EraseAt(int i)
-{
-	return erase(v[i]);
-}
+	public:
 
-template <typename T>
-int Container<T>::find(const T& t)
-{
-	return (*s.find(t)).idx;
-}
+		iterator(uint64_t rest) : rest(rest) {}
 
-template <typename T>
-bool Container<T>::present(const T& t)
-{
-	return s.find(t) != s.end();
-}
+		int operator*() const { return __builtin_ctzll(rest) + 1; }
+		iterator& operator++() { rest &= rest - 1; return *this; }
+		bool operator==(const iterator& it) const { return rest == it.rest; }
+		bool operator!=(const iterator& it) const { return rest != it.rest; }
+	};
 
-template <typename T>
-const T& Container<T>::GetRandom()
-{
+	iterator begin() const { return iterator(bits); }
+	iterator end() const { return iterator(0); }
+	iterator find(int num) const { return bits & Bit(num) ? iterator(bits & ~(Bit(num) - 1)) : end(); }
 
-#if NO_RANDOMIZATION
-	return (*s.begin()).t; // to disable the random behavior.
-#endif
+	bool insert(int num) { bool res = !(bits & Bit(num)); bits |= Bit(num); return res; }
+	bool erase(int num) { bool res = (bits & Bit(num)) != 0; bits &= ~Bit(num); return res; }
+	void erase(iterator it) { bits &= ~Bit(*it); }
 
-    return v[RNG::GetRandomNumber(v.size())];
-}
+	int size() const { return __builtin_popcountll(bits); }
+	bool empty() const { return !bits; }
+	void clear() { bits = 0; }
 
-template <typename T>
-T Container<T>::PopRandom()
-{
-	T ret = GetRandom();
-	erase(ret);
-	return ret;
-}
-
-template <typename T>
-int Container<T>::size() const
-{
-	return s.size();
-}
-
-template <typename T>
-bool Container<T>::empty() const
-{
-	return s.empty();
-}
-
-template <typename T>
-bool Container<T>::clear()
-{
-	s.clear();
-	v.clear();
-}
+	// bit (num - 1) for every num.
+	uint64_t Bits() const { return bits; }
+	void SetBits(uint64_t bits) { this->bits = bits; }
+};
 
 //--------------------------------------------------------------------
 
@@ -149,9 +59,9 @@ class LiteContainer
 public:
 
     LiteContainer(std::vector<T> v) : v(v) {}
-	LiteContainer(std::set<T> s)
+	LiteContainer(const NumberSet& s)
 	{
-		for (auto i : s)
+		for (int i : s)
 			v.push_back(i);
 
 #if NO_RANDOMIZATION
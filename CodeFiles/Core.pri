@@ -0,0 +1,51 @@
+# solver core, shared by the GUI and the command line tools.
+# nothing here may depend on QtWidgets, or on POSIX: the GUI also builds with MinGW.
+# the tools add those parts, and what links against them, in Tools.pri.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+        $$PWD/batchgenerator.cpp \
+        $$PWD/bitboardsolver.cpp \
+        $$PWD/canonical.cpp \
+        $$PWD/compactboard.cpp \
+        $$PWD/gridvalidator.cpp \
+        $$PWD/lanesolver.cpp \
+        $$PWD/masksolver.cpp \
+        $$PWD/metrics.cpp \
+        $$PWD/puzzlegenerator.cpp \
+        $$PWD/puzzleio.cpp \
+        $$PWD/puzzlepool.cpp \
+        $$PWD/rng.cpp \
+        $$PWD/solverstats.cpp \
+        $$PWD/sudokuboard.cpp \
+        $$PWD/sudokusolver.cpp \
+        $$PWD/sudokutransform.cpp \
+        $$PWD/threadpool.cpp \
+        $$PWD/trace.cpp \
+        $$PWD/unitgraph.cpp
+
+HEADERS += \
+        $$PWD/BatchGenerator.h \
+        $$PWD/BitboardSolver.h \
+        $$PWD/BoundedQueue.h \
+        $$PWD/Canonical.h \
+        $$PWD/CompactBoard.h \
+        $$PWD/Container.h \
+        $$PWD/FLAGS.h \
+        $$PWD/Grid.h \
+        $$PWD/GridValidator.h \
+        $$PWD/LaneSolver.h \
+        $$PWD/MaskSolver.h \
+        $$PWD/Metrics.h \
+        $$PWD/PuzzleGenerator.h \
+        $$PWD/PuzzleIO.h \
+        $$PWD/PuzzlePool.h \
+        $$PWD/RNG.h \
+        $$PWD/SolverStats.h \
+        $$PWD/SudokuBoard.h \
+        $$PWD/SudokuSolver.h \
+        $$PWD/SudokuTransform.h \
+        $$PWD/ThreadPool.h \
+        $$PWD/Trace.h \
+        $$PWD/UnitGraph.h
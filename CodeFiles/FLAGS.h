@@ -1,14 +1,19 @@
 #pragma once
 
+// the bench can be built with them on (see SudokuBench.pro).
+#ifndef APPLY_STRATEGIES
 #define APPLY_STRATEGIES 0
+#endif
 
 #define NO_RANDOMIZATION 0
 
-#define	PRINT_DEBUG_FUNCTIONS			0
-#define PRINT_DEBUG_BOARDS				0
-#define PRINT_DEBUG_BOARDS_INFORMATION	0
 #define PRINT_DEBUG_ERRORS				0
 
+// what SudokuBoard records of its changes (see Trace.h): 0 nothing, 1 a ring buffer, 2 a file.
+#ifndef BOARD_TRACE
+#define BOARD_TRACE						0
+#endif
+
 #if APPLY_STRATEGIES
 
 #define APPLY_NakedSingles			1
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "SudokuBoard.h"
+#include <vector>
+#include <algorithm>
+
+// a board stored row by row in one vector: cell { r, c } is grid[r * N + c].
+// 0 = empty, same as Board.
+typedef std::vector<int> Grid;
+
+inline Grid ToGrid(const Board& board, int N)
+{
+	Grid grid(N * N, 0);
+
+	for (int i = 0; i < std::min((int)board.size(), N); i++)
+		for (int j = 0; j < std::min((int)board[i].size(), N); j++)
+			grid[i * N + j] = board[i][j];
+
+	return grid;
+}
+
+inline Board ToBoard(const Grid& grid, int N)
+{
+	Board board(N, std::vector<int>(N, 0));
+
+	for (int i = 0; i < N; i++)
+		for (int j = 0; j < N; j++)
+			board[i][j] = grid[i * N + j];
+
+	return board;
+}
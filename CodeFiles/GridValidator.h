@@ -0,0 +1,29 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include <cstdint>
+#include <cstddef>
+
+// checks finished grids by their contents alone, so it works on solutions from anywhere
+// (SudokuSolver::Validate only checks the bookkeeping of the solver).
+// a grid is valid if every row, column and box has each number once, and if it has a puzzle,
+// if it keeps every clue of the puzzle.
+namespace GridValidator
+{
+	// the batch layout: 81 bytes per 9 * 9 grid, row by row, the numbers themselves (not characters),
+	// 0 for an empty cell of a puzzle.
+	const size_t GridBytes = 81;
+
+	// checks count grids, puzzles is either nullptr or count puzzles in the same layout.
+	// valid[i] is set to 1 if grid i is valid and to 0 if not, valid may be nullptr.
+	// returns the number of valid grids.
+	// each grid is checked in a few 16 byte vectors, with an AVX2 kernel if the CPU has it.
+	size_t Validate(const uint8_t* grids, const uint8_t* puzzles, size_t count, uint8_t* valid);
+
+	// any size up to 64 * 64, the size comes from the number of cells. an empty puzzle means none.
+	bool Validate(const Grid& grid, const Grid& puzzle = Grid());
+
+	// writes grid into the batch layout, false if it isn't 9 * 9 or has a number out of range.
+	bool ToBytes(const Grid& grid, uint8_t* out);
+}
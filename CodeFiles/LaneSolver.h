@@ -0,0 +1,51 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include <vector>
+#include <cstdint>
+
+// constraint propagation on up to 16 independent 9 * 9 puzzles at once.
+// the candidates of a cell are 9 bits, and every cell is one vector of 16 such masks,
+// one puzzle per lane, so every step works on all the puzzles together.
+// the lanes run naked and hidden singles in lockstep until none of them changes;
+// what is left is solved, or needs a search (or has a contradiction) and is
+// meant for one of the other solvers.
+//
+// like BitboardSolver the kernel is compiled for AVX2 and for the baseline instruction set.
+class LaneSolver
+{
+public:
+
+	typedef uint16_t Vector __attribute__((vector_size(32)));
+	typedef uint32_t (*Kernel)(Vector* cells);
+
+	static const int Lanes = 16;
+
+private:
+
+	// the cells need 32 byte alignment, so they live in a buffer aligned by hand.
+	std::vector<char> memory;
+	Vector* cells;
+
+	uint32_t loaded;
+	Kernel kernel;
+
+public:
+
+	LaneSolver();
+	LaneSolver(const LaneSolver&) = delete;
+	LaneSolver& operator= (const LaneSolver&) = delete;
+
+	// empties every lane.
+	void Clear();
+
+	// puts puzzle in lane, false if it isn't 9 * 9 or has a number out of range (the lane stays empty).
+	bool Load(int lane, const Grid& puzzle);
+
+	// propagates every lane, bit i of the result is set if lane i was solved.
+	uint32_t Propagate();
+
+	// the board of lane, only a solution if Propagate said so.
+	void GetSolution(int lane, Grid& solution) const;
+};
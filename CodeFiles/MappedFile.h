@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// a read only file mapped into memory (POSIX mmap).
+// a path of "-" reads the standard input into a buffer instead, so pipes work the same way.
+class MappedFile
+{
+	const char* data;
+	size_t size;
+	void* mapping;
+	std::string buffer;
+
+public:
+
+	MappedFile() : data(nullptr), size(0), mapping(nullptr) {}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator= (const MappedFile&) = delete;
+	~MappedFile() { Close(); }
+
+	bool Open(const std::string& path);
+	void Close();
+
+	const char* Data() const { return data; }
+	size_t Size() const { return size; }
+
+	// the end of the chunk that starts at begin: about ChunkSize bytes, up to right after a newline
+	// (or the end of the file). the chunks are cut one at a time, as the file is read.
+	size_t ChunkEnd(size_t begin, size_t ChunkSize) const;
+};
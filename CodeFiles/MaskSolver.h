@@ -0,0 +1,118 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include "RNG.h"
+#include "UnitGraph.h"
+#include "SolverStats.h"
+#include <vector>
+#include <cstdint>
+
+#define Mask uint64_t
+
+// a bitmask solver for boards up to 64 * 64 (BoxN <= 8), classic or any variant of UnitGraph.
+// the candidates of a cell are one word, bit (num - 1) is set if num is a candidate.
+// unlike SudokuSolver it copies the whole state on every branch instead of undoing it,
+// which is what makes it fast enough for uniqueness checks and generation.
+// the search is a loop over an explicit stack, so a 64 * 64 board can go thousands of
+// levels deep on any thread.
+class MaskSolver
+{
+	// the cell a search level branches on and the candidates it hasn't tried yet.
+	struct Choice
+	{
+		int cell;
+		Mask left;
+	};
+
+	int N, BoxN, Cells;
+	Mask All;												// all N candidates.
+
+	UnitGraph graph;										// the units, the peers of every cell and the overlaps.
+	std::vector<Mask> stack;								// one frame of Cells candidates per search depth.
+	std::vector<Choice> choices;							// one per search depth.
+	std::vector<int> queue;									// cells waiting to be propagated.
+	Grid solution;											// first solution found.
+
+	bool loaded;											// false if the loaded board has a contradiction.
+	int limit, count;
+	long long NodeLimit;									// 0 for none.
+	bool stopped;											// the last search reached NodeLimit.
+	bool randomized, LockedCandidates;
+	Xoshiro256 rng;
+
+	Mask* Frame(int depth) { return &stack[depth * Cells]; }
+
+	// sets cell to the single candidate bit and deletes it from every peer,
+	// cells left with a single candidate are set the same way.
+	bool Assign(Mask* cand, int cell, Mask bit);
+
+	// deletes bits from the candidates of cell, and assigns it if one is left.
+	bool Eliminate(Mask* cand, int cell, Mask bits);
+
+	// deletes the numbers a unit keeps to the cells it shares with another unit from the rest of
+	// the other one, over the families of the graph (pointing and claiming on a classic board).
+	// false on a contradiction.
+	bool Lock(Mask* cand, bool& Changed);
+
+	// sets hidden singles until none are left, and applies locked candidates
+	// whenever the singles run out.
+	bool Propagate(Mask* cand);
+
+	// the cell with the fewest candidates, -1 if every cell is set.
+	int Choose(const Mask* cand) const;
+
+	void Search();
+
+public:
+
+	// number of search nodes in the last call to CountSolutions.
+	long long NumberOfNodes;
+
+	// cells set by naked and hidden singles and candidates deleted by locked candidates
+	// since the last Load, the clues and the guesses of the search aren't counted.
+	long long Propagations[SolverStats::Strategies];
+
+	MaskSolver(int BoxN = 3);
+
+	// the classic board of that size.
+	void ResizeBoard(int BoxN) { SetUnits(UnitGraph(BoxN)); }
+
+	// the solver takes the units of graph, its size too.
+	void SetUnits(const UnitGraph& graph);
+	int Size() const { return N; }
+
+	// randomizes the order in which candidates are tried.
+	void SetRandomized(bool randomized) { this->randomized = randomized; }
+	void Seed(uint64_t seed) { rng.Seed(seed); }
+
+	// a search stops after this many nodes, 0 for no limit.
+	void SetNodeLimit(long long NodeLimit) { this->NodeLimit = NodeLimit; }
+
+	// true if the last CountSolutions reached the node limit, it only counted the solutions found by then.
+	bool Stopped() const { return stopped; }
+
+	// locked candidates (pointing and claiming) keep the tree of a large board small,
+	// they are on from 25 * 25 up and for every variant (SetUnits).
+	void SetLockedCandidates(bool LockedCandidates) { this->LockedCandidates = LockedCandidates; }
+
+	// returns false if the board has a contradiction.
+	bool Load(const Grid& grid);
+	bool Load(const Board& board) { return Load(ToGrid(board, N)); }
+
+	// deletes num from the candidates of idx in the loaded board.
+	bool Exclude(const Index& idx, int num);
+
+	// true if the naked singles of Load (and Exclude) left one candidate in every cell.
+	bool Settled() const;
+
+	// stops as soon as limit solutions are found.
+	int CountSolutions(int limit = 2);
+	bool Solve() { return CountSolutions(1) == 1; }
+	bool Unique() { return CountSolutions(2) == 1; }
+
+	const Grid& GetSolution() const { return solution; }
+
+	// the solver and its tables and search stack on the heap.
+	size_t MemoryUsage() const;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "FLAGS.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// latencies in the manner of HdrHistogram: SubBuckets linear buckets per power of two,
+// so a bucket is at most 1 / SubBuckets (about 3%) wide, from 1 ns to 2^40 ns (about 18 minutes).
+// one thread records and any thread may read at the same time: the owner updates the atomics
+// with relaxed loads and stores, there is no lock and no locked instruction.
+class LatencyHistogram
+{
+	static void Add(std::atomic<uint64_t>& a, uint64_t n) { a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+public:
+
+	static const int SubBits = 5, SubBuckets = 1 << SubBits;
+	static const int MaxBits = 40;
+	static const int Size = (MaxBits - SubBits + 1) * SubBuckets;
+
+	std::atomic<uint64_t> buckets[Size];
+	std::atomic<uint64_t> count, nanoseconds;
+
+	LatencyHistogram() { Clear(); }
+	LatencyHistogram(const LatencyHistogram&) = delete;
+	LatencyHistogram& operator= (const LatencyHistogram&) = delete;
+
+	// the bucket of ns.
+	static int Bucket(uint64_t ns)
+	{
+		if (ns < (uint64_t)SubBuckets)
+			return (int)ns;
+
+		if (ns >> MaxBits)
+			return Size - 1;
+
+		int exponent = 63 - __builtin_clzll(ns);
+		return (exponent - SubBits + 1) * SubBuckets + (int)((ns >> (exponent - SubBits)) & (SubBuckets - 1));
+	}
+
+	// the ns just above the bucket.
+	static uint64_t UpperBound(int bucket);
+
+	// only by the thread that owns the histogram.
+	void Record(uint64_t ns)
+	{
+		Add(buckets[Bucket(ns)], 1);
+		Add(count, 1);
+		Add(nanoseconds, ns);
+	}
+
+	void Record(double seconds) { Record((uint64_t)(seconds > 0 ? seconds * 1e9 : 0)); }
+
+	// neither while another thread records.
+	void Clear();
+	void Merge(const LatencyHistogram& other);
+
+	// the upper bound of the bucket holding quantile q, in seconds.
+	double Quantile(double q) const;
+	double Mean() const;
+};
+
+// the solves of one thread: how long they took and what came of them.
+// every thread records into its own, a reader merges them whenever it wants a total.
+struct SolveMetrics
+{
+	// the first ones are in the order of SolveStatus.
+	enum Counter { Solved, Unsolvable, Invalid, TimedOut, CacheHits, Counters };
+
+	LatencyHistogram latency;
+	std::atomic<uint64_t> counters[Counters];
+
+	SolveMetrics() { Clear(); }
+
+	void Count(Counter counter) { counters[counter].store(counters[counter].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+	void Clear();
+	void Merge(const SolveMetrics& other);
+
+	// the Prometheus text format, every name starts with prefix:
+	// a histogram prefix_solve_seconds, the quantiles 0.5 to 0.999 as prefix_solve_seconds_quantile
+	// and the counters prefix_puzzles_total{status} and prefix_cache_hits_total.
+	void AppendPrometheus(std::string& out, const std::string& prefix) const;
+};
+
+// writes the text of source every interval seconds on its own thread, and once more when destroyed.
+// a file is written next to itself and renamed over, so a scraper never reads half of it.
+// "-" is the standard output.
+class MetricsExporter
+{
+	std::string path;
+	double interval;
+	std::function<std::string()> source;
+
+	std::thread thread;
+	std::mutex m;
+	std::condition_variable wake;
+	bool stop;
+
+	void Run();
+
+public:
+
+	MetricsExporter(const std::string& path, double interval, std::function<std::string()> source);
+	MetricsExporter(const MetricsExporter&) = delete;
+	MetricsExporter& operator= (const MetricsExporter&) = delete;
+	~MetricsExporter();
+
+	// false if the file can't be written.
+	bool Write();
+};
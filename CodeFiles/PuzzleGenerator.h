@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "MaskSolver.h"
+#include <vector>
+#include <random>
+
+// which cells are removed together, so the clues keep the symmetry.
+enum class Symmetry
+{
+	None,
+	Rotational,		// cell { r, c } with { N - 1 - r, N - 1 - c }.
+	Mirror,			// cell { r, c } with { r, N - 1 - c }.
+	Diagonal		// cell { r, c } with { c, r }.
+};
+
+// how much a puzzle needs beyond naked singles.
+enum class Difficulty
+{
+	Easy,			// naked singles are enough.
+	Medium,			// hidden singles are needed.
+	Hard,			// a few guesses are needed.
+	Expert			// a deep search is needed.
+};
+
+// generates puzzles with exactly one solution.
+// clues are removed from a solved grid one at a time (or one symmetric group at a time)
+// and a removal is only kept if the puzzle is still uniquely solvable.
+class PuzzleGenerator
+{
+	int N, BoxN, Cells;
+	MaskSolver solver;
+	Xoshiro256 rng;
+
+	// the cells removed together with cell.
+	void Orbit(int cell, Symmetry symmetry, std::vector<int>& orbit) const;
+
+	// true if the puzzle has no solution other than the given one.
+	bool Unique(const Grid& puzzle, const Grid& solution, const std::vector<int>& removed);
+
+public:
+
+	PuzzleGenerator(int BoxN = 3);
+	PuzzleGenerator(int BoxN, uint64_t seed);
+
+	// the classic board of that size.
+	void ResizeBoard(int BoxN) { SetUnits(UnitGraph(BoxN)); }
+
+	// puzzles of a variant, the solver takes the units of graph.
+	void SetUnits(const UnitGraph& graph);
+	void Seed(uint64_t seed);
+
+	// fills grid with a random solved board.
+	bool FillGrid(Grid& grid);
+
+	// removes clues from solution while the puzzle stays unique, stopping at clues.
+	// if minimal, clues is ignored and every clue that can be removed is removed.
+	// returns the number of clues left in puzzle.
+	int RemoveClues(const Grid& solution, Grid& puzzle, int clues,
+					Symmetry symmetry = Symmetry::None, bool minimal = false);
+
+	// true if puzzle has exactly one solution.
+	bool Unique(const Grid& puzzle);
+
+	Difficulty Grade(const Grid& puzzle);
+
+	// FillGrid followed by RemoveClues.
+	int Generate(Grid& puzzle, Grid& solution, int clues,
+				 Symmetry symmetry = Symmetry::None, bool minimal = false);
+};
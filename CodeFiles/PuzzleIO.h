@@ -0,0 +1,32 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include <string>
+
+// the line format: one board per line, N * N characters row by row.
+// '1'..'9' then 'A'..'Z', 'a'..'z' and "@#$" are the numbers 1..64, '0' and '.' are empty cells.
+namespace PuzzleIO
+{
+	// the character of num (0 = '.').
+	char Symbol(int num);
+
+	// the number of c, -1 if c isn't a valid character.
+	int Number(char c);
+
+	// BoxN of a line with length characters, 0 if the length isn't a square of a square.
+	int BoxSize(size_t length);
+
+	// true if the first field of a line is a comment: it starts with '#' and isn't as long as a 64 * 64 board,
+	// the only board where '#' is a number (63).
+	bool Comment(const char* field, size_t length);
+
+	std::string ToLine(const Grid& grid);
+
+	// appends the line of grid to out, without a newline.
+	void AppendLine(std::string& out, const Grid& grid);
+
+	// reads length characters, returns false if a character is invalid or too big for the board.
+	bool FromLine(const char* line, size_t length, Grid& grid, int& BoxN);
+	bool FromLine(const std::string& line, Grid& grid, int& BoxN);
+}
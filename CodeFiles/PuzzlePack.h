@@ -0,0 +1,83 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+// a packed binary file of boards of one size.
+//
+// header (32 bytes, little endian):
+//   "SDKP", version (u16), BoxN (u8), bits per cell (u8), flags (u32), count (u64), 12 reserved bytes.
+// then count records of RecordBytes each. a record is the puzzle packed with bits per cell
+// (the smallest width that holds 0..N, 4 for 9 * 9: 41 bytes instead of an 82 byte line),
+// followed by the packed solution if the file has solutions.
+// records have a fixed size, so the index of the record i is just its offset.
+namespace PuzzlePack
+{
+	const uint32_t HasSolutions = 1;
+	const size_t HeaderSize = 32;
+
+	int CellBits(int BoxN);
+	size_t BoardBytes(int BoxN);
+
+	void Pack(const Grid& grid, int bits, uint8_t* out);
+	void Unpack(const uint8_t* in, int bits, int cells, Grid& grid);
+
+	// true if data starts with a valid header.
+	bool IsPacked(const char* data, size_t size);
+}
+
+class PuzzlePackWriter
+{
+	FILE* file;
+	int BoxN, bits;
+	uint32_t flags;
+	uint64_t count;
+	std::vector<uint8_t> record;
+
+	bool WriteHeader();
+
+public:
+
+	PuzzlePackWriter() : file(nullptr), BoxN(0), bits(0), flags(0), count(0) {}
+	~PuzzlePackWriter() { Close(); }
+
+	bool Open(const std::string& path, int BoxN, bool solutions);
+
+	// solution is ignored if the file has no solutions.
+	bool Add(const Grid& puzzle, const Grid& solution = Grid());
+
+	// writes the final count into the header.
+	bool Close();
+};
+
+class PuzzlePackReader
+{
+	MappedFile file;
+	const uint8_t* records;
+	int BoxN, bits;
+	uint32_t flags;
+	uint64_t count;
+	size_t RecordBytes;
+
+public:
+
+	PuzzlePackReader() : records(nullptr), BoxN(0), bits(0), flags(0), count(0), RecordBytes(0) {}
+
+	// false if the file can't be read or isn't a valid pack.
+	bool Open(const std::string& path);
+
+	// reads a pack that is already in memory, data must outlive the reader.
+	bool Attach(const char* data, size_t size);
+
+	int BoxSize() const { return BoxN; }
+	uint64_t Count() const { return count; }
+	bool Solutions() const { return flags & PuzzlePack::HasSolutions; }
+
+	const uint8_t* Record(uint64_t i) const { return records + i * RecordBytes; }
+	void Puzzle(uint64_t i, Grid& grid) const;
+	bool Solution(uint64_t i, Grid& grid) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "PuzzleGenerator.h"
+#include <map>
+#include <deque>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct PoolKey
+{
+	int BoxN, clues;
+	bool operator< (const PoolKey& key) const
+	{
+		return BoxN < key.BoxN || (BoxN == key.BoxN && clues < key.clues);
+	}
+};
+
+// keeps unique puzzles ready so a new game doesn't wait for the generator.
+// a worker thread refills every wanted key up to PerKey puzzles, the most recently wanted first.
+// only the last MaxKeys wanted keys are kept, an older one is dropped with its puzzles.
+// if a path is given, the puzzles are loaded from it on construction and saved on destruction.
+class PuzzlePool
+{
+	std::map<PoolKey, std::deque<Grid>> puzzles;
+	std::deque<PoolKey> wanted;							// the keys of puzzles, the most recently wanted first.
+	size_t PerKey, MaxKeys;
+	std::string path;
+	std::function<void(const PoolKey&)> ready;
+
+	bool quit;
+	std::mutex m;
+	std::condition_variable WorkChanged;
+	std::thread worker;
+
+	// a wanted key with less than PerKey puzzles, false if there is none.
+	bool Missing(PoolKey& key) const;
+
+	// moves key to the front of wanted, the lock must be held.
+	void Touch(const PoolKey& key);
+	void Work();
+
+public:
+
+	PuzzlePool(size_t PerKey = 16, const std::string& path = "", size_t MaxKeys = 4);
+	~PuzzlePool();
+
+	// called on the worker thread after a puzzle of key is added.
+	void SetReady(std::function<void(const PoolKey&)> ready);
+
+	// keeps key filled from now on.
+	void Want(const PoolKey& key);
+
+	// takes a puzzle out of the pool, false if none is ready yet (it never generates one itself,
+	// the worker does and calls ready). the key is wanted from now on, like Want.
+	bool Take(const PoolKey& key, Grid& puzzle);
+
+	bool Load();
+	bool Save();
+};
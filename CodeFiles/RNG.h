@@ -1,16 +1,95 @@
 #pragma once
 
 #include "FLAGS.h"
-#include <random>
-#include <QRandomGenerator>
+#include <cstdint>
 
-//TODO: write more efficient code.
-
-class RNG
+// xoshiro256** (Blackman and Vigna): 32 bytes of state, a few cycles per number.
+// it meets the requirements of a uniform random bit generator, so it also works
+// with std::shuffle and the std distributions.
+class Xoshiro256
 {
+	uint64_t s[4];
+
+	static uint64_t Rotate(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
 public:
-    static int GetRandomNumber(int min, int max);
-    static int GetRandomNumber(int max);
+
+	typedef uint64_t result_type;
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return UINT64_MAX; }
+
+	explicit Xoshiro256(uint64_t seed = 0) { Seed(seed); }
+
+	// the state is filled by splitmix64, so close seeds give unrelated sequences.
+	void Seed(uint64_t seed);
+
+	// the whole state, to continue a sequence exactly where it was.
+	void GetState(uint64_t state[4]) const { for (int i = 0; i < 4; i++) state[i] = s[i]; }
+	void SetState(const uint64_t state[4]) { for (int i = 0; i < 4; i++) s[i] = state[i]; }
+
+	result_type operator()()
+	{
+		uint64_t result = Rotate(s[1] * 5, 7) * 9, t = s[1] << 17;
+
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = Rotate(s[3], 45);
+
+		return result;
+	}
+
+	// uniform in [0, bound) without bias, by Lemire's multiply and reject:
+	// the high half of x * bound is the result, and only the rare x that would
+	// make some results more likely are drawn again (no division in the common case).
+	uint32_t Bounded(uint32_t bound)
+	{
+		uint64_t m = (uint64_t)(uint32_t)((*this)() >> 32) * bound;
+
+		if ((uint32_t)m < bound)
+		{
+			uint32_t threshold = (0u - bound) % bound;
+			while ((uint32_t)m < threshold)
+				m = (uint64_t)(uint32_t)((*this)() >> 32) * bound;
+		}
+
+		return (uint32_t)(m >> 32);
+	}
 };
 
+// the random numbers of the containers and the solvers.
+// every thread draws from its own generator, so solvers on different threads don't share state.
+// that is a generator of the thread unless a Scope made another one current,
+// which is how a solver with its own seed makes its search reproducible.
+class RNG
+{
+public:
+
+	// makes rng the generator of the calling thread until the scope ends.
+	class Scope
+	{
+		Xoshiro256* previous;
+
+	public:
+
+		Scope(Xoshiro256& rng);
+		Scope(const Scope&) = delete;
+		Scope& operator= (const Scope&) = delete;
+		~Scope();
+	};
+
+	static Xoshiro256& Current();
+
+	// reseeds the generator of the calling thread.
+	static void Seed(uint64_t seed);
+
+	// a seed from std::random_device, for generators that don't need to be reproducible.
+	static uint64_t RandomSeed();
+
+	// in [min, max) and [0, max).
+	static int GetRandomNumber(int min, int max);
+	static int GetRandomNumber(int max);
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Canonical.h"
+#include <list>
+#include <unordered_map>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <memory>
+
+// a bounded LRU cache of 9 * 9 solutions, shared by many threads.
+// entries are keyed by the canonical hash, so a puzzle and every equivalent puzzle
+// (relabeled, permuted, transposed) share one entry: the solution is stored in canonical
+// form and mapped back through the transformation of the puzzle that asks for it.
+// the cache is split in shards with their own lock and LRU list.
+class SolutionCache
+{
+	// canonical puzzle and solution, 4 bits per cell (see PuzzlePack).
+	typedef std::array<uint8_t, 41> Packed;
+
+	struct Entry
+	{
+		uint64_t hash;
+		Packed puzzle, solution;
+	};
+
+	struct Shard
+	{
+		std::mutex m;
+		std::list<Entry> lru;											// most recently used first.
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> map;
+	};
+
+	static const int ShardCount = 16;
+
+	std::unique_ptr<Shard[]> shards;
+	size_t PerShard;
+
+	Shard& GetShard(uint64_t hash) { return shards[hash % ShardCount]; }
+	void Put(uint64_t hash, const Packed& puzzle, const Packed& solution);
+
+public:
+
+	std::atomic<long long> hits, misses, inserts, evictions;
+
+	// capacity is the maximum number of entries.
+	SolutionCache(size_t capacity);
+
+	// false on a miss (or if the puzzle isn't 9 * 9).
+	// form gets the canonical form either way, so a miss can be inserted without computing it again.
+	bool Lookup(const Grid& puzzle, Grid& solution, CanonicalForm& form);
+	bool Lookup(const Grid& puzzle, Grid& solution);
+
+	// form is the canonical form of the puzzle solved by solution.
+	void Insert(const CanonicalForm& form, const Grid& solution);
+	void Insert(const Grid& puzzle, const Grid& solution);
+
+	size_t Size();
+
+	// bytes held by the entries and the maps, including the allocator headers that are known.
+	size_t MemoryUsage();
+	double HitRate() const;
+
+	// binary file: "SDKC", entry count (u64), then hash (u64), puzzle and solution of every entry,
+	// least recently used first so loading keeps the order.
+	bool Save(const std::string& path);
+	bool Load(const std::string& path);
+};
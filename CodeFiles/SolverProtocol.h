@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// the protocol of SudokuServer, over a Unix domain socket.
+//
+// both ways the stream is a sequence of frames:
+//   length (u32, little endian, the bytes after it), id (u32), code (u8), body (length - 5 bytes).
+// a request has code 0 and the puzzle in the line format as its body.
+// a response has the id of its request, the status as its code (0 solved, 1 unsolvable, 2 invalid, 3 timeout)
+// and the solution as its body (the puzzle as it was sent unless solved).
+// responses come in the order of the requests of the connection, so a client can keep
+// many requests in flight and match them by order or by id.
+namespace SolverProtocol
+{
+	const size_t HeaderSize = 9;
+
+	// the largest body: a 64 * 64 board. a bigger frame closes the connection.
+	const size_t MaxBody = 64 * 64;
+
+	const uint8_t Request = 0;
+
+	void AppendFrame(std::string& out, uint32_t id, uint8_t code, const char* body, size_t length);
+
+	// write everything, retrying short writes and signals, false on error.
+	bool WriteAll(int fd, const char* data, size_t size);
+
+	// the socket at path, -1 on error (errno is set). a socket file left at path by a server
+	// that is gone is replaced, a live server gives EADDRINUSE and other files are kept.
+	int Listen(const std::string& path, int backlog = 64);
+	int Connect(const std::string& path);
+}
+
+// reads frames through a buffer, so a stream of small frames takes few system calls.
+class FrameReader
+{
+	int fd;
+	std::vector<char> buffer;
+	size_t begin, end;
+
+public:
+
+	FrameReader(int fd) : fd(fd), buffer(1 << 16), begin(0), end(0) {}
+
+	// body points into the buffer until the next call.
+	// false at the end of the stream, on an error or on a frame that is too big.
+	bool Next(uint32_t& id, uint8_t& code, const char*& body, size_t& length);
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "BatchSolver.h"
+#include "BoundedQueue.h"
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+class SolutionCache;
+
+struct ServerOptions
+{
+	std::string path = "/tmp/sudoku.sock";
+	int threads = 0;							// 0 = all cores.
+	Engine engine = Engine::Sudoku;
+	bool lanes = false;							// see BatchSolver::SetLanes.
+	double TimeLimit = 0;						// seconds, see BatchSolver::SetTimeLimit.
+
+	// requests solved together at most, and requests waiting at most.
+	// a full queue stops reading from the clients, which bounds the memory.
+	int MaxBatch = 256;
+	int QueueSize = 4096;
+
+	// connections beyond this are closed right away.
+	int MaxClients = 256;
+
+	// bytes of responses a client may leave unread, past them it's dropped.
+	size_t MaxPending = 16 << 20;
+
+	SolutionCache* cache = nullptr;
+};
+
+// a local solving server (see SolverProtocol.h).
+// every client has a thread that reads its requests into one shared queue,
+// a dispatcher takes whatever is queued (up to MaxBatch) and solves it with one SolveBatch,
+// so a burst of small requests costs one wake up of the pool instead of one per request.
+// the responses of a batch are queued per connection and sent without blocking, what a
+// client doesn't take right away is sent from the poll loop of Run, so a slow client
+// never holds up the others.
+class SolverServer
+{
+	// closes the socket when the last request that refers to it is answered
+	// and the responses are sent.
+	struct Connection
+	{
+		int fd;
+		std::mutex write;
+		std::string pending;					// responses not sent yet, under write.
+		std::atomic<bool> broken;
+
+		Connection(int fd) : fd(fd), broken(false) {}
+		~Connection();
+
+		// sends what it can of pending without blocking, true once nothing is left.
+		bool Flush();
+
+		// under write: stops the reader and forgets the responses.
+		void Drop();
+	};
+
+	struct Job
+	{
+		std::shared_ptr<Connection> connection;
+		uint32_t id;
+		Grid puzzle;
+		std::string line;						// the request as sent, only kept if it can't be parsed.
+	};
+
+	// the connection is only owned by its reader and its requests, so it's closed
+	// (and the client sees the end of the stream) right after the last response.
+	struct Client
+	{
+		std::thread reader;
+		std::weak_ptr<Connection> connection;
+		std::shared_ptr<std::atomic<bool>> done;
+	};
+
+	ServerOptions options;
+	BatchSolver solver;
+	BoundedQueue<Job> queue;
+	std::list<Client> clients;
+
+	// connections the dispatcher left responses to, and a pipe that wakes the poll loop up.
+	std::mutex OutboxLock;
+	std::vector<std::shared_ptr<Connection>> outbox;
+	int wake[2];
+
+	// the connections the poll loop sends to, only used by Run.
+	std::unordered_map<Connection*, std::shared_ptr<Connection>> sending;
+
+	void Read(std::shared_ptr<Connection> connection);
+	void Dispatch();
+
+	// waits up to timeout ms for the listener (-1 = none) or for clients to take their
+	// responses, and sends them. true if a client is waiting to be accepted.
+	bool Poll(int listener, int timeout);
+
+	// joins the readers of the clients that are gone.
+	void Reap();
+
+public:
+
+	// totals since Run started.
+	std::atomic<long long> requests, batches, connections;
+
+	// the SolveMetrics of the solver and the totals in the Prometheus text format, at any time.
+	void AppendPrometheus(std::string& out, const std::string& prefix) const;
+
+	SolverServer(const ServerOptions& options);
+
+	// serves until stop is set, then answers the queued requests and returns.
+	// false if the socket can't be created (errno is set).
+	bool Run(const std::atomic<bool>& stop);
+};
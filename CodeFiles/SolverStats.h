@@ -0,0 +1,61 @@
+#pragma once
+
+#include "FLAGS.h"
+#include <string>
+#include <cstdint>
+
+// what a search did, for one solve or added up over many.
+// everything is a counter in a fixed array, so keeping it costs a few increments per node
+// and nothing is allocated.
+struct SolverStats
+{
+	// the strategies of SudokuSolver (see FLAGS.h), and the singles of the other engines.
+	enum Strategy { NakedSingles, HiddenSingles, PointingClaiming, Strategies };
+	enum Phase { Load, Propagate, Search, Phases };
+
+	// branch points deeper than this are counted at the last depth,
+	// branching factors and candidate counts above it in the last bucket.
+	static const int Depths = 64;
+	static const int Buckets = 17;
+
+	long long solves, solved;
+	long long nodes;							// calls of the search (SudokuSolver::NumberOfCalls).
+	long long assignments;						// numbers the search put in a cell.
+	long long backtracks;						// of those, the ones taken back.
+	int MaxDepth;
+
+	// cells placed or candidates removed by each strategy.
+	long long propagations[Strategies];
+
+	// seconds, search doesn't include propagate.
+	double seconds[Phases];
+
+	// number of candidates of the cell chosen at each branch point.
+	long long CandidatesAtBranch[Buckets];
+
+	// for each depth, how many children a branch point tried before it was solved or gave up.
+	long long BranchingFactor[Depths][Buckets];
+
+	SolverStats() { Clear(); }
+
+	void Clear();
+	void Add(const SolverStats& other);
+
+	// a branch point at depth with candidates numbers to try, and the children it tried.
+	void Branch(int depth, int candidates)
+	{
+		CandidatesAtBranch[candidates < Buckets ? candidates : Buckets - 1]++;
+		if (depth > MaxDepth)
+			MaxDepth = depth;
+	}
+
+	void Tried(int depth, int children)
+	{
+		BranchingFactor[depth < Depths ? depth : Depths - 1][children < Buckets ? children : Buckets - 1]++;
+	}
+
+	// appends one JSON object, the histograms are arrays by bucket
+	// and branching_factor has one array per depth up to MaxDepth.
+	void AppendJson(std::string& out) const;
+	std::string ToJson() const;
+};
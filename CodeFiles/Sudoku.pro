@@ -22,22 +22,16 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-CONFIG += c++11
+CONFIG += c++11 thread
+
+include(Core.pri)
 
 SOURCES += \
         main.cpp \
         mainwindow.cpp \
-        rng.cpp \
-        selectnum.cpp \
-        sudokuboard.cpp \
-        sudokusolver.cpp
+        selectnum.cpp
 
 HEADERS += \
-        Container.h \
-        FLAGS.h \
-        RNG.h \
-        SudokuBoard.h \
-        SudokuSolver.h \
         mainwindow.h \
         selectnum.h
 
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# headless batch solver, no QtWidgets.
+#
+#-------------------------------------------------
+
+# the core is plain C++, no Qt module is needed.
+CONFIG -= qt
+
+TARGET = SudokuBatch
+TEMPLATE = app
+
+CONFIG += c++11 console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(Tools.pri)
+
+SOURCES += \
+        batchmain.cpp
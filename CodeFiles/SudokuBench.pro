@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# solver benchmark, no QtWidgets.
+#
+#-------------------------------------------------
+
+# the core is plain C++, no Qt module is needed.
+CONFIG -= qt
+
+TARGET = SudokuBench
+TEMPLATE = app
+
+CONFIG += c++11 console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# qmake CONFIG+=strategies builds SudokuSolver with APPLY_STRATEGIES, the bench then
+# reports any wrong solution the strategies lead to.
+strategies: DEFINES += APPLY_STRATEGIES=1
+
+include(Tools.pri)
+
+SOURCES += \
+        benchmain.cpp
@@ -2,13 +2,16 @@
 
 #include "FLAGS.h"
 #include "Container.h"
+#include "UnitGraph.h"
 #include <vector>
-#include <set>
+#include <cstdint>
 
 #define Board	   std::vector<std::vector<int>>
 #define EmptyBoard std::vector<std::vector<int>>()
 #define Candidates candidates[idx.r][idx.c]
 
+struct CompactBoard;
+
 struct Index
 {
 	int r, c;
@@ -26,27 +29,46 @@ class SudokuBoard
 
 	int N, BoxN;											// board = N * N, BoxN = sqrt(N).
 	Board board;											// 2d vector of int.
-	std::vector<std::vector<bool>> row, column, box;		// 2d vector of bool.
-	std::vector<std::vector<std::set<int>>> candidates;		// 2d vector of Container of int.
-	std::set<int> available;								// stores the indcies of non empty Containers in CellsWithNCandidates.
+	UnitGraph graph;										// the units, rows, columns and boxes unless SetUnits says otherwise.
+	std::vector<uint64_t> unit;								// bit (num - 1) is set if num is in unit u of graph.
+	std::vector<std::vector<NumberSet>> candidates;			// 2d vector of sets of int.
+	uint64_t available;										// bit (i - 1) is set if CellsWithNCandidates[i] isn't empty, i in 1..N.
 
-	// CellsWithNCandidates[i] stores the indcies of cells with i candidates.
+	// CellsWithNCandidates[i] stores the indcies of empty cells with i candidates, in no order.
 	// if CellsWithNCandidates[0] is not empty then the board is invalid.
-	std::vector<Container<Index>> CellsWithNCandidates;
-
-#if APPLY_PointingClaming
+	// a cell is erased by moving the last one into its place, BucketPosition[r * N + c] is
+	// where cell { r, c } is in its bucket (-1 if it isn't in one).
+	std::vector<std::vector<Index>> CellsWithNCandidates;
+	std::vector<int> BucketPosition;
 
-	// xxxIndices[i][j] will have the indices of cells in xxx number i that contain the candidate j.
-	std::vector<std::vector<std::set<Index>>> RowIndices, ColumnIndices, BoxIndices;
+	// the numbers placed in the units of cell (r * N + c).
+	uint64_t Placed(int cell) const;
 
-#endif
+	// Reload from cell(r, c).
+	template <typename Cell> bool Load(Cell cell);
 
 public:
 	SudokuBoard(const Board& board = EmptyBoard, int BoxN = 3);
 	SudokuBoard(int BoxN, const Board& board = EmptyBoard)
 		: SudokuBoard(board, BoxN) {}
 
+	// the box of idx, its region on a jigsaw.
 	int BoxNum(const Index& idx) const;
+	int Size() const { return N; }
+
+	// a random cell of CellsWithNCandidates[CandidatesCount] (the smallest with NO_RANDOMIZATION).
+	const Index& GetRandomCell(int CandidatesCount) const;
+
+	const Board& GetCells() const { return board; }
+
+	// the bytes of the board and everything it holds on the heap, as asked from the allocator
+	// (its own headers aren't counted).
+	size_t MemoryUsage() const;
+
+	// a 9 * 9 board to and from its CompactBoard, ToCompact is false for other sizes and variants.
+	// SetBoard makes the board a classic 9 * 9 and gives it the cells and candidates of compact.
+	bool ToCompact(CompactBoard& compact) const;
+	void SetBoard(const CompactBoard& compact);
 
 	// if CandidatesCount == -1, updates for every number.
 	void UpdateAvailable(int CandidatesCount = -1);
@@ -68,45 +90,29 @@ public:
 	bool inRow(int r, int num) const;
 	bool inColumn(int c, int num) const;
 	bool inBox(int b, int num) const;
+	bool inUnit(int u, int num) const;
 
 	// if the given board is smaller, the rest is cosidered empty.
 	// if the given board is bigger, the rest is ignored.
+	// with clear the board is reloaded (see Reload), else the cells are set one by one.
 	void SetBoard(const Board& board, bool clear = false);
-	void ResizeBoard(int BoxN, bool keep = false);
-	void Clear();
-
-	template <typename T, typename... Args>
-	void ForEachCellInRow(int c, T func, Args... args);
 
-	template <typename T, typename... Args>
-	void ForEachCellInColumn(int r, T func, Args... args);
+	// the board becomes the given one without allocating (once the buckets have grown for this size):
+	// the cells are written in place, the candidates of every cell come from the unit masks in one pass
+	// and the buckets are filled once at the end. a clue that contradicts an earlier one is skipped,
+	// the same as with SetCell, and so is a number out of range. false if a clue was skipped.
+	bool Reload(const Board& board);
 
-	template <typename T, typename... Args>
-	void ForEachCellInBox(int b, T func, Args... args);
-};
-
-
-template <typename T, typename... Args>
-void SudokuBoard::ForEachCellInRow(int r, T func, Args... args)
-{
-	for (int c = 0; c < N; c++)
-		(this->*func)({ r, c }, args...);
-}
+	// the same from the N * N cells row by row (a Grid, see Grid.h).
+	bool Reload(const std::vector<int>& cells);
 
-template <typename T, typename... Args>
-void SudokuBoard::ForEachCellInColumn(int c, T func, Args... args)
-{
-	for (int r = 0; r < N; r++)
-		(this->*func)({ r, c }, args...);
-}
+	// the classic board of that size.
+	void ResizeBoard(int BoxN, bool keep = false) { SetUnits(UnitGraph(BoxN), keep); }
 
-template <typename T, typename... Args>
-void SudokuBoard::ForEachCellInBox(int b, T func, Args... args)
-{
-	int r = (b / BoxN) * BoxN;
-	int c = (b % BoxN) * BoxN;
+	// the board takes the units of graph (a variant), its size too.
+	// with keep the cells are set again under the new units, else the board is empty.
+	void SetUnits(const UnitGraph& graph, bool keep = false);
+	const UnitGraph& GetUnits() const { return graph; }
 
-	for (int i = 0; i < BoxN; i++)
-		for (int j = 0; j < BoxN; j++)
-			(this->*func)({ r + i, c + j }, args...);
-}
+	void Clear();
+};
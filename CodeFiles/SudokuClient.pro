@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# command line client of SudokuServer.
+#
+#-------------------------------------------------
+
+# the core is plain C++, no Qt module is needed.
+CONFIG -= qt
+
+TARGET = SudokuClient
+TEMPLATE = app
+
+CONFIG += c++11 console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(Tools.pri)
+
+SOURCES += \
+        clientmain.cpp
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# headless batch puzzle generator.
+#
+#-------------------------------------------------
+
+# the core is plain C++, no Qt module is needed.
+CONFIG -= qt
+
+TARGET = SudokuGenerator
+TEMPLATE = app
+
+CONFIG += c++11 console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(Tools.pri)
+
+SOURCES += \
+        generatormain.cpp
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# converter between the line format and the packed format.
+#
+#-------------------------------------------------
+
+# the core is plain C++, no Qt module is needed.
+CONFIG -= qt
+
+TARGET = SudokuPack
+TEMPLATE = app
+
+CONFIG += c++11 console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(Tools.pri)
+
+SOURCES += \
+        packmain.cpp
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# local solving server on a Unix domain socket, no QtWidgets.
+#
+#-------------------------------------------------
+
+# the core is plain C++, no Qt module is needed.
+CONFIG -= qt
+
+TARGET = SudokuServer
+TEMPLATE = app
+
+CONFIG += c++11 console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(Tools.pri)
+
+SOURCES += \
+        servermain.cpp
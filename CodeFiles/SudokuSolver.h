@@ -2,10 +2,15 @@
 
 #include "FLAGS.h"
 #include "SudokuBoard.h"
+#include "SolverStats.h"
+#include "Trace.h"
 #include <functional>
+#include <atomic>
 #include <chrono>
 #include <algorithm>
 #include "RNG.h"
+#include "PuzzleGenerator.h"
+#include "SudokuTransform.h"
 
 #define TimePoint std::chrono::time_point<std::chrono::steady_clock>
 #define SudokuSolverDuration std::chrono::duration<double>
@@ -23,7 +28,14 @@ class SudokuSolver
 	// starts with an empty 9 * 9 board.
 	SudokuBoard board;
 
+	// the random choices of the search, seeded from std::random_device unless Seed is called.
+	Xoshiro256 rng;
+
+	// the time of the last LoadBoard, it goes into the stats of the next Solve.
+	double LoadSeconds = 0;
+
 	bool Possible() const;
+	bool Return(bool solved);
 	void StartDuration();
 	void EndDuration();
 
@@ -35,6 +47,24 @@ public:
 	// number of calls that didn't stop on a base-case.
 	int NumberOfValidCalls;
 
+	// depth of the current recursive call.
+	int Depth = 0;
+
+	// true if the last Solve was stopped by the cancel flag.
+	bool Cancelled = false;
+
+	// the cancel flag and the progress callback are looked at every ProgressInterval calls.
+	static const int ProgressInterval = 4096;
+
+	// may be set from another thread, Solve then returns false with Cancelled set.
+	std::atomic<bool>* cancel = nullptr;
+
+	// called on the solving thread with the number of calls and the depth.
+	std::function<void(long long, int)> progress;
+
+	// records every Solve while set, the trace is owned by the caller.
+	SearchTrace* trace = nullptr;
+
 	// unless solved, StartTime, EndTime, duration will not be useful.
 	// Starting and Ending time for solving.
 	TimePoint StartTime, EndTime;
@@ -42,22 +72,49 @@ public:
 	// the time it took to solve (in seconds).
     SudokuSolverDuration SolvingDuration;
 
-	SudokuSolver() {};
-	SudokuSolver(SudokuBoard board) : board(board) {};
+	// the statistics of the last Solve (and the LoadBoard before it).
+	// propagate is only timed when strategies are applied (see FLAGS.h).
+	SolverStats stats;
+
+	SudokuSolver() : rng(RNG::RandomSeed()) {};
+	SudokuSolver(SudokuBoard board) : board(board), rng(RNG::RandomSeed()) {};
+
+	// the same seed and board give the same search, on any thread.
+	void Seed(uint64_t seed) { rng.Seed(seed); }
+
+	// continues the sequence of generator, to run a search again from a SearchTrace.
+	void Seed(const Xoshiro256& generator) { rng = generator; }
 
 	const SudokuBoard& GetBoard() const { return board; }
+
+	// the solver and its board, see SudokuBoard::MemoryUsage.
+	// the copies a search makes on every node only live while it runs and aren't counted.
+	size_t MemoryUsage() const { return sizeof(*this) - sizeof(board) + board.MemoryUsage(); }
     const SudokuSolverDuration& GetDuration() const { return SolvingDuration; }
 
 	void Clear();
+	void ResizeBoard(int BoxN) { board.ResizeBoard(BoxN); }
+	void SetUnits(const UnitGraph& graph) { board.SetUnits(graph); }
 	void LoadBoard(const Board& board);
 
+	// LoadBoard from a grid of N * N cells, without allocating.
+	// false if a clue contradicts an earlier one (it is skipped, see SudokuBoard::Reload).
+	bool LoadGrid(const Grid& grid);
+
 	// if there exist more than best cell, the next one is chosen randomly.
 	Index GetNextCell(); 
 
 	bool Solve();
     bool SetRandomCells(int cells);
+
+	// like SetRandomCells but the puzzle is guaranteed to have one solution.
+	// may keep more than cells clues if no more can be removed.
+	bool SetUniqueCells(int cells, Symmetry symmetry = Symmetry::None, bool minimal = false);
+
 	bool Backtrack();
 	bool Validate() const;
+
+	// generates n boards from one solution using SudokuTransform.
 	void GenerateBoards(int n, std::vector<std::vector<std::vector<int>>>& list, int shuffle = 0);
 	void ChangeNumbers(std::vector<std::vector<int>>& b, std::vector<int>& permutation);
 
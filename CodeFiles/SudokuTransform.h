@@ -0,0 +1,92 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "Grid.h"
+#include <vector>
+#include <algorithm>
+#include <random>
+
+// a transformation that maps a valid board to another valid board:
+// band and stack permutations, row and column permutations inside them,
+// transposition and relabeling of the numbers.
+// the whole transformation is kept as one map over the cells, so applying it is a single copy.
+class SudokuTransform
+{
+	int N, BoxN;
+
+	// the cell i of the result comes from the cell CellMap[i].
+	std::vector<int> CellMap;
+
+	// the number n becomes NumberMap[n], NumberMap[0] = 0 (empty stays empty).
+	std::vector<int> NumberMap;
+
+public:
+
+	// the identity.
+	SudokuTransform(int BoxN = 3);
+
+	// RowMap[r] is the row (of the original board) that becomes row r, same for ColumnMap.
+	// the transposition is applied after the permutations.
+	// RowMap and ColumnMap must keep rows in their bands (columns in their stacks).
+	SudokuTransform(int BoxN, bool transpose, const std::vector<int>& RowMap,
+					const std::vector<int>& ColumnMap, const std::vector<int>& NumberMap);
+
+	// a transformation chosen uniformly from the whole group.
+	template <typename Engine>
+	static SudokuTransform Random(int BoxN, Engine& rng);
+
+	// a map of N lines that keeps the lines of each block together.
+	template <typename Engine>
+	static std::vector<int> RandomLines(int BoxN, Engine& rng);
+
+	int Size() const { return N; }
+	const std::vector<int>& GetCellMap() const { return CellMap; }
+	const std::vector<int>& GetNumberMap() const { return NumberMap; }
+
+	// in and out hold N * N cells each and must not overlap.
+	void Apply(const int* in, int* out) const;
+	void Apply(const Grid& in, Grid& out) const;
+	Board Apply(const Board& board) const;
+
+	// undoes Apply: ApplyInverse(Apply(board)) == board.
+	void ApplyInverse(const int* in, int* out) const;
+	void ApplyInverse(const Grid& in, Grid& out) const;
+};
+
+template <typename Engine>
+std::vector<int> SudokuTransform::RandomLines(int BoxN, Engine& rng)
+{
+	std::vector<int> blocks(BoxN), lines(BoxN), map;
+
+	for (int i = 0; i < BoxN; i++)
+		blocks[i] = i;
+	std::shuffle(blocks.begin(), blocks.end(), rng);
+
+	for (int b : blocks)
+	{
+		for (int i = 0; i < BoxN; i++)
+			lines[i] = b * BoxN + i;
+		std::shuffle(lines.begin(), lines.end(), rng);
+
+		map.insert(map.end(), lines.begin(), lines.end());
+	}
+
+	return map;
+}
+
+template <typename Engine>
+SudokuTransform SudokuTransform::Random(int BoxN, Engine& rng)
+{
+	int N = BoxN * BoxN;
+
+	std::vector<int> numbers(N + 1);
+	for (int i = 0; i <= N; i++)
+		numbers[i] = i;
+	std::shuffle(numbers.begin() + 1, numbers.end(), rng);
+
+	bool transpose = std::uniform_int_distribution<int>(0, 1)(rng);
+	std::vector<int> rows = RandomLines(BoxN, rng);
+	std::vector<int> columns = RandomLines(BoxN, rng);
+
+	return SudokuTransform(BoxN, transpose, rows, columns, numbers);
+}
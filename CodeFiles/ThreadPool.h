@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+// a fixed set of workers that run parallel loops.
+// a loop over [0, count) is split in one range per worker, a worker takes items from the
+// front of its own range and when it's empty steals the back half of the biggest range left,
+// so a few slow items don't leave the other workers idle.
+// the calling thread is worker 0, a pool of one thread runs everything on the caller.
+class ThreadPool
+{
+	struct Range
+	{
+		std::mutex m;
+		size_t begin = 0, end = 0;
+		char padding[64];							// keeps the ranges of two workers off one cache line.
+	};
+
+	std::vector<std::thread> threads;
+	std::unique_ptr<Range[]> ranges;
+	int size;
+
+	std::function<void(int, size_t)> job;
+	std::mutex m;
+	std::condition_variable started, finished;
+	long long generation;
+	int running;
+	bool quit;
+
+	bool Next(int worker, size_t& i);
+	bool Steal(int worker);
+	void Work(int worker);
+	void Loop(int worker);
+
+public:
+
+	// 0 threads means one per core.
+	ThreadPool(int threads = 0);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator= (const ThreadPool&) = delete;
+	~ThreadPool();
+
+	int Size() const { return size; }
+
+	// calls f(worker, i) for every i in [0, count) and returns when all calls are done.
+	// worker is in [0, Size()), so f can keep state per worker without locking.
+	void ParallelFor(size_t count, std::function<void(int, size_t)> f);
+};
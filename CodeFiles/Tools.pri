@@ -0,0 +1,21 @@
+# the command line tools: the core, and what only builds on POSIX systems.
+# the GUI includes Core.pri alone, so none of this reaches its MinGW kit.
+
+include(Core.pri)
+
+# the batch solver reaches the memory mapped files through the solution cache and the pack format.
+SOURCES += \
+        $$PWD/batchsolver.cpp \
+        $$PWD/mappedfile.cpp \
+        $$PWD/puzzlepack.cpp \
+        $$PWD/solutioncache.cpp \
+        $$PWD/solverprotocol.cpp \
+        $$PWD/solverserver.cpp
+
+HEADERS += \
+        $$PWD/BatchSolver.h \
+        $$PWD/MappedFile.h \
+        $$PWD/PuzzlePack.h \
+        $$PWD/SolutionCache.h \
+        $$PWD/SolverProtocol.h \
+        $$PWD/SolverServer.h
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "FLAGS.h"
+#include "RNG.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// tracing of the changes SudokuBoard makes while it is searched.
+// the board calls BoardTrace::Record for every change, and BoardTrace is one of the
+// policies below, picked with BOARD_TRACE in FLAGS.h:
+//   NoTrace    (0) records nothing, the calls are empty inline functions and cost nothing.
+//   RingTrace  (1) keeps the last events of each thread in memory.
+//   FileTrace  (2) writes every event of a thread to the binary file it opened.
+//
+// the search of SudokuSolver is recorded separately, at run time, by a SearchTrace.
+
+enum class TraceEvent : uint8_t
+{
+	Reset,						// the board was cleared, num is BoxN.
+	SetCell,
+	UnsetCell,
+	DeleteCandidate,
+	AddCandidate,
+	MoveBucket,					// an empty cell moved from the bucket of from candidates to to.
+
+	// the events of a search (SearchTrace).
+	Node,						// a call of the search started.
+	Propagate,					// the strategies made count changes in the node.
+	Decision,					// num was put in the cell chosen by the node, which had count candidates.
+	Backtrack,					// num was taken back out of the cell.
+	Return						// the node returned, num is 1 if the board was solved.
+};
+
+const char* TraceEventName(TraceEvent event);
+
+// 8 bytes, boards up to 64 * 64 fit in the bytes.
+struct TraceRecord
+{
+	TraceEvent event;
+	uint8_t r, c, num;
+	uint8_t from, to;
+	uint16_t reserved;
+};
+
+struct NoTrace
+{
+	static void Record(TraceEvent, int, int, int, int = 0, int = 0) {}
+};
+
+class RingTrace
+{
+	struct Ring
+	{
+		std::vector<TraceRecord> records;
+		uint64_t count = 0;
+	};
+
+	static Ring& Local();
+
+public:
+
+	// events kept per thread, the oldest are overwritten. takes effect on the next Clear.
+	static void SetCapacity(size_t capacity);
+
+	static void Record(TraceEvent event, int r, int c, int num, int from = 0, int to = 0)
+	{
+		Ring& ring = Local();
+		ring.records[ring.count++ & (ring.records.size() - 1)] = { event, (uint8_t)r, (uint8_t)c, (uint8_t)num, (uint8_t)from, (uint8_t)to, 0 };
+	}
+
+	// events recorded by this thread since Clear, including the overwritten ones.
+	static uint64_t Count();
+
+	// the events of this thread that are still kept, oldest first.
+	static void Copy(std::vector<TraceRecord>& out);
+	static void Clear();
+};
+
+// file: "SDKT", version (u16), record size (u16), then the records.
+class FileTrace
+{
+	struct Writer
+	{
+		FILE* file = nullptr;
+		std::vector<TraceRecord> buffer;
+		~Writer();
+	};
+
+	static Writer& Local();
+	static void Flush(Writer& writer);
+
+public:
+
+	static const size_t HeaderSize = 8;
+
+	// the file of this thread, a file that was open is closed first.
+	static bool Open(const std::string& path);
+	static bool Close();
+
+	static void Record(TraceEvent event, int r, int c, int num, int from = 0, int to = 0)
+	{
+		Writer& writer = Local();
+		if (!writer.file)
+			return;
+
+		writer.buffer.push_back({ event, (uint8_t)r, (uint8_t)c, (uint8_t)num, (uint8_t)from, (uint8_t)to, 0 });
+		if (writer.buffer.size() == writer.buffer.capacity())
+			Flush(writer);
+	}
+
+	// reads a whole trace file, false if it isn't one.
+	static bool Read(const std::string& path, std::vector<TraceRecord>& records);
+};
+
+// 16 bytes, time is in nanoseconds since the search started.
+struct SearchRecord
+{
+	TraceEvent event;
+	uint8_t r, c, num;
+	uint16_t depth, count;
+	uint64_t time;
+};
+
+// the nodes, decisions, propagations and backtracks of one SudokuSolver::Solve, with the cells
+// and the generator state it started from, so the same search can be run again.
+// the records are kept in memory, or written to the file as they come if Open was called.
+// file: "SDKS", version (u16), record size (u16), BoxN (u8), 7 bytes padding,
+//       the generator state (4 * u64), the N * N cells (u8), then the records.
+class SearchTrace
+{
+	std::string path;
+	FILE* file = nullptr;
+	std::chrono::steady_clock::time_point start;
+
+	void Flush();
+
+public:
+
+	int BoxN = 0;
+	std::vector<uint8_t> cells;
+	uint64_t state[4] = {};
+	std::vector<SearchRecord> records;
+
+	SearchTrace() = default;
+	SearchTrace(const SearchTrace&) = delete;
+	SearchTrace& operator= (const SearchTrace&) = delete;
+	~SearchTrace() { End(); }
+
+	// the next search is written to path, replacing the file.
+	void Open(const std::string& path) { this->path = path; }
+
+	// called by the solver when a search starts and ends. false if the file can't be written.
+	bool Begin(int BoxN, const std::vector<int>& cells, const Xoshiro256& rng);
+	bool End();
+
+	void Record(TraceEvent event, int depth, int r = 0, int c = 0, int num = 0, int count = 0)
+	{
+		uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		records.push_back({ event, (uint8_t)r, (uint8_t)c, (uint8_t)num, (uint16_t)depth, (uint16_t)std::min(count, 65535), time });
+
+		if (file && records.size() >= 4096)
+			Flush();
+	}
+
+	// the generator as it was when the search started.
+	Xoshiro256 Generator() const;
+
+	// reads a whole trace file, false if it isn't one.
+	static bool Read(const std::string& path, SearchTrace& trace);
+};
+
+#if BOARD_TRACE == 1
+typedef RingTrace BoardTrace;
+#elif BOARD_TRACE == 2
+typedef FileTrace BoardTrace;
+#else
+typedef NoTrace BoardTrace;
+#endif
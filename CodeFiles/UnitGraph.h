@@ -0,0 +1,96 @@
+#pragma once
+
+#include "FLAGS.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// the units of a board as data: a unit is N cells that hold every number once.
+// the rows come first, then the columns, then the boxes (or the regions of a jigsaw),
+// a variant adds its own after them (the diagonals, the windows of windoku).
+// every change compiles the units into the tables the solvers walk, so a solver never
+// looks at the shape of a unit.
+class UnitGraph
+{
+public:
+
+	// the overlaps of one unit with others, in cells no two of them share (see Families).
+	struct Family
+	{
+		int unit;
+		std::vector<int> segment;						// the segment of every cell of unit, in unit order.
+		std::vector<int> others;						// the unit overlapping in each segment, the last segment is every other cell.
+		std::vector<std::vector<int>> targets;			// the cells of others[s] that aren't in unit.
+	};
+
+private:
+
+	int N, BoxN, Cells;
+	bool classic;
+
+	std::vector<int> units;								// UnitCount() * N cells, unit u starts at u * N.
+	std::vector<int> regions;							// the box (or region) of every cell.
+
+	// compressed lists, the list of cell i is at [start[i], start[i + 1]).
+	std::vector<int> UnitStart, CellUnits;				// the units of a cell.
+	std::vector<int> ScopeStart, scope;					// the cells of those units, the cell too.
+	std::vector<int> PeerStart, peers;					// the same without the cell.
+
+	std::vector<Family> families;
+
+	void Compile();
+
+public:
+
+	// the classic board of that size, rows, columns and boxes.
+	UnitGraph(int BoxN = 3);
+
+	void Reset(int BoxN);
+
+	// the boxes become regions, regions[cell] in [0, N) and N cells each.
+	// false (and nothing changes) otherwise.
+	bool SetRegions(const std::vector<int>& regions);
+
+	// false if the cells aren't N different cells.
+	bool AddUnit(const std::vector<int>& cells);
+
+	// the two long diagonals.
+	void AddDiagonals();
+
+	// the (BoxN - 1)^2 windows of windoku, the boxes between the boxes (rows and columns 1 to 3 and 5 to 7 on 9 * 9).
+	void AddWindows();
+
+	// "classic", or parts joined by '+': "diagonal", "windoku" and "jigsaw:" followed by the region of every cell,
+	// one character each (any N different characters, N times each), e.g. "jigsaw:111222...+diagonal".
+	// false if spec isn't one, or the jigsaw isn't BoxN^4 cells.
+	static bool Parse(const std::string& spec, int BoxN, UnitGraph& graph);
+
+	int Size() const { return N; }
+	int BoxSize() const { return BoxN; }
+	int CellCount() const { return Cells; }
+	int UnitCount() const { return units.size() / (N ? N : 1); }
+
+	// only rows, columns and square boxes, the units the 9 * 9 only solvers assume.
+	bool Classic() const { return classic; }
+
+	const int* Unit(int u) const { return &units[u * N]; }
+	int Region(int cell) const { return regions[cell]; }
+
+	// the units of cell, ascending.
+	const int* UnitsBegin(int cell) const { return &CellUnits[UnitStart[cell]]; }
+	const int* UnitsEnd(int cell) const { return &CellUnits[UnitStart[cell + 1]]; }
+
+	// every cell that shares a unit with cell, the cell too, unit by unit in the order of the units.
+	const int* ScopeBegin(int cell) const { return &scope[ScopeStart[cell]]; }
+	const int* ScopeEnd(int cell) const { return &scope[ScopeStart[cell + 1]]; }
+
+	// the same without the cell itself.
+	const int* PeersBegin(int cell) const { return &peers[PeerStart[cell]]; }
+	const int* PeersEnd(int cell) const { return &peers[PeerStart[cell + 1]]; }
+
+	// the overlaps of two or more cells (but not all of them) between units, grouped so that a pass over a unit
+	// finds every number one family keeps to one of its segments: pointing and claiming on a classic board.
+	const std::vector<Family>& Families() const { return families; }
+
+	size_t MemoryUsage() const;
+};
@@ -0,0 +1,170 @@
+#include "BatchGenerator.h"
+#include <thread>
+#include <random>
+#include <unordered_set>
+
+// splitmix64, spreads consecutive seeds over the whole range.
+static uint64_t Mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+BatchGenerator::BatchGenerator(const GeneratorOptions& options)
+    : options(options), stop(false), next(0), finished(0), Window(0), NumberOfCandidates(0)
+{
+}
+
+bool BatchGenerator::Take(long long& index)
+{
+    std::unique_lock<std::mutex> lock(WindowMutex);
+    WindowChanged.wait(lock, [this] { return stop || next - finished < Window; });
+
+    if (stop || (options.MaxCandidates && next >= options.MaxCandidates))
+        return false;
+
+    index = next++;
+    return true;
+}
+
+void BatchGenerator::Finish()
+{
+    std::lock_guard<std::mutex> lock(WindowMutex);
+    finished++;
+    WindowChanged.notify_all();
+}
+
+void BatchGenerator::RunStage(BoundedQueue<GeneratedPuzzle>& in, BoundedQueue<GeneratedPuzzle>& out,
+                              std::atomic<int>& alive, std::function<void(PuzzleGenerator&, GeneratedPuzzle&)> f)
+{
+    PuzzleGenerator generator(options.BoxN, 0);
+    GeneratedPuzzle item;
+
+    while (in.pop(item))
+    {
+        f(generator, item);
+        if (!out.push(std::move(item)))
+            break;
+    }
+
+    if (--alive == 0)
+        out.close();
+}
+
+long long BatchGenerator::Run(std::function<void(const GeneratedPuzzle&)> output)
+{
+    const GeneratorOptions& o = options;
+    int Cells = o.BoxN * o.BoxN * o.BoxN * o.BoxN;
+
+    stop = false;
+    next = finished = 0;
+    Window = std::max(4 * o.QueueSize, 8 * o.threads);
+
+    BoundedQueue<GeneratedPuzzle> grids(o.QueueSize), removed(o.QueueSize), graded(o.QueueSize);
+
+    // clue removal is by far the slowest stage, it gets most of the workers.
+    int small = std::max(1, o.threads / 8);
+    int RemoveWorkers = std::max(1, o.threads - 2 * small);
+    std::atomic<int> GridAlive(small), RemoveAlive(RemoveWorkers), GradeAlive(small);
+
+    std::vector<std::thread> workers;
+
+    // full grid.
+    for (int i = 0; i < small; i++)
+        workers.emplace_back([this, &grids, &GridAlive]
+        {
+            PuzzleGenerator generator(options.BoxN, 0);
+            GeneratedPuzzle item;
+
+            while (Take(item.index))
+            {
+                item.seed = Mix(options.seed + item.index);
+                generator.Seed(Mix(item.seed + 1));
+                generator.FillGrid(item.solution);
+
+                if (!grids.push(item))
+                    break;
+            }
+
+            if (--GridAlive == 0)
+                grids.close();
+        });
+
+    // clue removal, a puzzle that couldn't get into the clue band is dropped.
+    for (int i = 0; i < RemoveWorkers; i++)
+        workers.emplace_back(&BatchGenerator::RunStage, this, std::ref(grids), std::ref(removed), std::ref(RemoveAlive),
+            [&o, Cells](PuzzleGenerator& generator, GeneratedPuzzle& item)
+            {
+                Xoshiro256 rng(Mix(item.seed + 2));
+                int clues = o.MinClues + (int)rng.Bounded(std::max(0, o.MaxClues - o.MinClues) + 1);
+
+                generator.Seed(rng());
+                item.clues = generator.RemoveClues(item.solution, item.puzzle, std::min(clues, Cells), o.symmetry);
+                item.accepted = item.clues >= o.MinClues && item.clues <= o.MaxClues;
+            });
+
+    // grading, and the canonical hash for deduplication.
+    for (int i = 0; i < small; i++)
+        workers.emplace_back(&BatchGenerator::RunStage, this, std::ref(removed), std::ref(graded), std::ref(GradeAlive),
+            [&o](PuzzleGenerator& generator, GeneratedPuzzle& item)
+            {
+                static thread_local Canonicalizer canonicalizer;
+
+                if (!item.accepted)
+                    return;
+
+                item.difficulty = generator.Grade(item.puzzle);
+                item.accepted = item.difficulty >= o.MinDifficulty && item.difficulty <= o.MaxDifficulty;
+
+                if (item.accepted && o.deduplicate)
+                    item.hash = canonicalizer.Hash(item.puzzle);
+            });
+
+    // results come in any order, they are kept until every candidate before them is done.
+    std::map<long long, GeneratedPuzzle> pending;
+    std::unordered_set<uint64_t> seen;
+    long long expected = 0, produced = 0;
+    GeneratedPuzzle item;
+
+    while (produced < o.count && graded.pop(item))
+    {
+        long long index = item.index;
+        pending[index] = std::move(item);
+
+        for (auto it = pending.find(expected); produced < o.count && it != pending.end(); it = pending.find(expected))
+        {
+            // checked here, in order, so the same duplicate is dropped on every run.
+            if (it->second.accepted && o.deduplicate && !seen.insert(it->second.hash).second)
+                it->second.accepted = false;
+
+            if (it->second.accepted)
+            {
+                output(it->second);
+                produced++;
+            }
+
+            pending.erase(it);
+            expected++;
+            Finish();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(WindowMutex);
+        stop = true;
+        WindowChanged.notify_all();
+    }
+
+    grids.close();
+    removed.close();
+    graded.close();
+
+    for (auto& worker : workers)
+        worker.join();
+
+    NumberOfCandidates = expected;
+
+    return produced;
+}
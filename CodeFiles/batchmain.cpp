@@ -0,0 +1,368 @@
+#include "BatchSolver.h"
+#include "PuzzleIO.h"
+#include "MappedFile.h"
+#include "PuzzlePack.h"
+#include "SolutionCache.h"
+#include "BoundedQueue.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+// headless batch solver.
+// reads one puzzle per line in the line format (N * N characters, anything after
+// the first space is ignored, empty lines and lines starting with '#' are skipped unless
+// they are as long as a 64 * 64 board, where '#' is the number 63)
+// and writes for each puzzle its solution (or the puzzle itself) and a status:
+// solved, unsolvable, invalid or timeout. a summary is written to the standard error.
+//
+// the input is mapped into memory and cut into chunks of about --chunk bytes (default 256 KB)
+// that end on a newline. the workers of a BatchSolver parse a chunk straight from the mapping,
+// solve its puzzles and format its output, so the parsing runs as parallel as the solving.
+// the chunks go in batches of 4 per worker: one thread cuts the next batch and another writes
+// the last one, in the original order, while the current one is solved.
+// a packed file (see PuzzlePack.h) is read the same way, in chunks of records.
+//
+// usage: SudokuBatch [--input file] [--output file] [--engine sudoku|mask|bitboard]
+//                    [--threads t] [--chunk bytes] [--cache entries] [--cache-file file] [--lanes on|off]
+//                    [--stats file] [--time-limit ms] [--metrics file] [--metrics-interval s] [--variant spec]
+//   sudoku (default) solves with SudokuSolver, mask with MaskSolver,
+//   bitboard with BitboardSolver (9 * 9, other sizes with MaskSolver).
+//   the input defaults to the standard input ("-").
+//   --cache keeps the solutions of 9 * 9 puzzles (and their equivalents) in a SolutionCache,
+//   --cache-file loads it on start and saves it on exit.
+//   --lanes on propagates 9 * 9 puzzles 16 at a time in SIMD lanes (see LaneSolver.h),
+//   only the ones that need a search are solved by the engine.
+//   --stats writes the SolverStats of the whole run as JSON.
+//   --time-limit stops a SudokuSolver search after ms milliseconds, the puzzle is then a timeout.
+//   --metrics writes the latencies and counts of the run in the Prometheus text format
+//   every --metrics-interval seconds (default 10) and at the end, "-" for the standard output.
+//   --variant solves every puzzle as that variant, e.g. diagonal, windoku or jigsaw:<region of every cell>
+//   (see UnitGraph::Parse), with SudokuSolver or MaskSolver.
+
+static const char* StatusNames[] = { "solved", "unsolvable", "invalid", "timeout" };
+
+// bytes [begin, end) of the input (records of a pack), the lines of its puzzles, its output
+// and the number of puzzles of each status so far.
+struct Chunk
+{
+    size_t begin = 0, end = 0;
+    std::vector<std::pair<const char*, size_t>> lines;
+    std::string text;
+    long long count[4] = { 0, 0, 0, 0 };
+};
+
+// a batch of chunks on its way from the cutter through the solver to the writer.
+// its chunks are reused from one batch to the next.
+struct Batch
+{
+    std::vector<Chunk> chunks;
+    size_t count = 0;
+
+    Batch(size_t size) : chunks(size) {}
+};
+
+static void Usage()
+{
+    std::fprintf(stderr, "usage: SudokuBatch [--input file] [--output file] [--engine sudoku|mask|bitboard]\n"
+                         "                   [--threads t] [--chunk bytes] [--cache entries] [--cache-file file] [--lanes on|off]\n"
+                         "                   [--stats file] [--time-limit ms] [--metrics file] [--metrics-interval s] [--variant spec]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    Engine engine = Engine::Sudoku;
+    std::string input = "-", output, CacheFile, StatsFile, MetricsFile, variant;
+    long long CacheSize = 0;
+    double TimeLimit = 0, MetricsInterval = 10;
+    int threads = 0;
+    bool lanes = false;
+    size_t ChunkSize = 1 << 18;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string value = argv[++i];
+
+        if (arg == "--input")
+            input = value;
+        else if (arg == "--output")
+            output = value;
+        else if (arg == "--threads")
+            threads = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--chunk")
+            ChunkSize = std::max(1LL, std::atoll(value.c_str()));
+        else if (arg == "--cache")
+            CacheSize = std::atoll(value.c_str());
+        else if (arg == "--cache-file")
+            CacheFile = value;
+        else if (arg == "--stats")
+            StatsFile = value;
+        else if (arg == "--time-limit")
+            TimeLimit = std::atof(value.c_str()) / 1000;
+        else if (arg == "--metrics")
+            MetricsFile = value;
+        else if (arg == "--metrics-interval")
+            MetricsInterval = std::atof(value.c_str());
+        else if (arg == "--variant")
+            variant = value;
+        else if (arg == "--lanes" && (value == "on" || value == "off"))
+            lanes = value == "on";
+        else if (arg == "--engine" && ParseEngine(value, engine))
+            continue;
+        else
+            return Usage(), 1;
+    }
+
+    std::unique_ptr<SolutionCache> cache;
+    if (CacheSize > 0)
+    {
+        cache.reset(new SolutionCache(CacheSize));
+        if (!CacheFile.empty())
+            cache->Load(CacheFile);
+    }
+
+    MappedFile file;
+    if (!file.Open(input))
+    {
+        std::perror(input.c_str());
+        return 1;
+    }
+
+    FILE* out = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+    if (!out)
+    {
+        std::perror(output.c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    PuzzlePackReader pack;
+    bool packed = pack.Attach(file.Data(), file.Size());
+
+    BatchSolver solver(threads, engine);
+    if (!solver.SetVariant(variant))
+    {
+        std::fprintf(stderr, "unknown variant: %s\n", variant.c_str());
+        return 1;
+    }
+
+    solver.SetCache(cache.get());
+    solver.SetLanes(lanes);
+    solver.SetTimeLimit(TimeLimit);
+
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!MetricsFile.empty())
+        exporter.reset(new MetricsExporter(MetricsFile, MetricsInterval, [&solver]
+        {
+            SolveMetrics metrics;
+            std::string text;
+
+            solver.Metrics(metrics);
+            metrics.AppendPrometheus(text, "sudoku");
+            return text;
+        }));
+
+    // one batch is cut, one solved and one written at a time, they go round through the queues.
+    const int InFlight = 3;
+    const size_t PerBatch = 4 * solver.Threads();
+    std::vector<std::unique_ptr<Batch>> batches;
+    BoundedQueue<Batch*> spare(InFlight), cut(InFlight), solved(InFlight);
+
+    for (int i = 0; i < InFlight; i++)
+    {
+        batches.emplace_back(new Batch(PerBatch));
+        spare.push(batches.back().get());
+    }
+
+    // a chunk of a pack has about as many puzzles as a chunk of lines.
+    size_t PackChunk = 0;
+    if (packed)
+    {
+        size_t N = pack.BoxSize() * pack.BoxSize();
+        PackChunk = std::max<size_t>(1, ChunkSize / (N * N + 1));
+    }
+
+    const char* data = file.Data();
+
+    std::thread cutter([&]
+    {
+        Batch* batch;
+        size_t begin = 0, size = packed ? pack.Count() : file.Size();
+
+        while (spare.pop(batch))
+        {
+            size_t n = 0;
+
+            for (; n < PerBatch && begin < size; n++)
+            {
+                size_t end = packed ? std::min(size, begin + PackChunk) : file.ChunkEnd(begin, ChunkSize);
+
+                batch->chunks[n].begin = begin;
+                batch->chunks[n].end = end;
+                begin = end;
+            }
+
+            if (!n)
+                break;
+
+            batch->count = n;
+            cut.push(batch);
+        }
+
+        cut.close();
+    });
+
+    std::thread writer([&]
+    {
+        Batch* batch;
+
+        while (solved.pop(batch))
+        {
+            for (size_t c = 0; c < batch->count; c++)
+                std::fwrite(batch->chunks[c].text.data(), 1, batch->chunks[c].text.size(), out);
+
+            spare.push(batch);
+        }
+    });
+
+    // the chunks are parsed, solved and formatted by the workers of the solver.
+    Batch* batch;
+    while (cut.pop(batch))
+    {
+        solver.SolveChunks(batch->count, [&](size_t c, std::vector<Grid>& puzzles)
+        {
+            Chunk& chunk = batch->chunks[c];
+            size_t n = 0;
+
+            if (packed)
+            {
+                for (uint64_t record = chunk.begin; record < chunk.end; record++, n++)
+                {
+                    if (n == puzzles.size())
+                        puzzles.emplace_back();
+
+                    pack.Puzzle(record, puzzles[n]);
+                }
+
+                return n;
+            }
+
+            chunk.lines.clear();
+
+            const char* begin = data + chunk.begin;
+            const char* end = data + chunk.end;
+
+            while (begin < end)
+            {
+                const char* newline = (const char*)std::memchr(begin, '\n', end - begin);
+                if (!newline)
+                    newline = end;
+
+                // the puzzle is the first field of the line.
+                const char* line = begin;
+                size_t length = 0;
+                while (line + length < newline && line[length] != ' ' && line[length] != '\t' && line[length] != '\r')
+                    length++;
+
+                begin = newline + 1;
+
+                if (!length || PuzzleIO::Comment(line, length))
+                    continue;
+
+                if (n == puzzles.size())
+                    puzzles.emplace_back();
+
+                // an empty grid is reported as invalid, and the line is written back as it was.
+                int BoxN;
+                if (!PuzzleIO::FromLine(line, length, puzzles[n], BoxN))
+                    puzzles[n].clear();
+
+                chunk.lines.emplace_back(line, length);
+                n++;
+            }
+
+            return n;
+        },
+        [&](size_t c, const Grid* puzzles, const SolveResult* results, size_t n)
+        {
+            Chunk& chunk = batch->chunks[c];
+            std::string& text = chunk.text;
+
+            text.clear();
+            for (size_t i = 0; i < n; i++)
+            {
+                SolveStatus status = results[i].status;
+                chunk.count[(int)status]++;
+
+                if (status == SolveStatus::Invalid && !packed)
+                    text.append(chunk.lines[i].first, chunk.lines[i].second);
+                else
+                    PuzzleIO::AppendLine(text, status == SolveStatus::Invalid ? puzzles[i] : results[i].solution);
+
+                text += ' ';
+                text += StatusNames[(int)status];
+                text += '\n';
+            }
+        });
+
+        solved.push(batch);
+    }
+
+    solved.close();
+    cutter.join();
+    writer.join();
+
+    long long count[4] = { 0, 0, 0, 0 };
+    for (const auto& each : batches)
+        for (const Chunk& chunk : each->chunks)
+            for (int i = 0; i < 4; i++)
+                count[i] += chunk.count[i];
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // the last export has everything.
+    exporter.reset();
+
+    if (!output.empty())
+        std::fclose(out);
+
+    if (cache && !CacheFile.empty() && !cache->Save(CacheFile))
+        std::perror(CacheFile.c_str());
+
+    if (!StatsFile.empty())
+    {
+        std::string json = solver.Stats().ToJson() + "\n";
+        FILE* file = std::fopen(StatsFile.c_str(), "w");
+
+        if (!file || std::fwrite(json.data(), 1, json.size(), file) != json.size() || std::fclose(file) != 0)
+            std::perror(StatsFile.c_str());
+    }
+
+    SolveMetrics metrics;
+    solver.Metrics(metrics);
+
+    long long n = metrics.latency.count;
+
+    std::fprintf(stderr, "%lld puzzles: %lld solved, %lld unsolvable, %lld invalid",
+                 n, count[0], count[1], count[2]);
+    if (TimeLimit > 0)
+        std::fprintf(stderr, ", %lld timeout", count[3]);
+    std::fprintf(stderr, "\n%.3f s, %.1f puzzles/s, mean %.1f us, p99 %.1f us\n",
+                 seconds, n / std::max(seconds, 1e-9), metrics.latency.Mean() * 1e6, metrics.latency.Quantile(0.99) * 1e6);
+
+    if (cache)
+        std::fprintf(stderr, "cache: %.1f%% hits, %zu entries, %.1f KB\n",
+                     cache->HitRate() * 100, cache->Size(), cache->MemoryUsage() / 1024.0);
+
+    return 0;
+}
@@ -0,0 +1,417 @@
+#include "BatchSolver.h"
+#include "SudokuSolver.h"
+#include "MaskSolver.h"
+#include "BitboardSolver.h"
+#include "LaneSolver.h"
+#include "SolutionCache.h"
+#include "UnitGraph.h"
+#include <algorithm>
+#include <chrono>
+
+// one solver of each kind, resized only when the size (or the variant) of the puzzles changes.
+struct BatchSolver::Worker
+{
+    SudokuSolver sudoku;
+    MaskSolver mask;
+    BitboardSolver bitboard;
+    LaneSolver lanes;
+    int BoxN = 3;
+
+    UnitGraph graph;
+    std::string variant;
+    bool valid = true;                      // variant has a board of size BoxN.
+
+    CanonicalForm form;
+    SolverStats stats;
+    std::vector<uint64_t> placed;           // numbers of each unit, for Conflicting.
+    SolveMetrics metrics;
+
+    // the puzzles and results of the chunk the worker solves, see SolveChunks.
+    std::vector<Grid> puzzles;
+    std::vector<SolveResult> results;
+
+    // SudokuSolver is cancelled through expired once its deadline has passed.
+    double TimeLimit = 0;
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<bool> expired;
+
+    Worker() : sudoku(3), mask(3), expired(false)
+    {
+        sudoku.cancel = &expired;
+        sudoku.progress = [this](long long, int)
+        {
+            if (TimeLimit > 0 && std::chrono::steady_clock::now() > deadline)
+                expired = true;
+        };
+    }
+
+    // a solve of an engine without its own stats, propagations is indexed by SolverStats::Strategy.
+    void Count(bool solved, long long nodes, const long long* propagations, double load, double search)
+    {
+        stats.solves++;
+        stats.solved += solved;
+        stats.nodes += nodes;
+        for (int i = 0; i < SolverStats::Strategies; i++)
+            stats.propagations[i] += propagations[i];
+        stats.seconds[SolverStats::Load] += load;
+        stats.seconds[SolverStats::Search] += search;
+    }
+
+    void Record(const SolveResult& result)
+    {
+        metrics.latency.Record(result.seconds);
+        metrics.Count((SolveMetrics::Counter)result.status);
+        if (result.cached)
+            metrics.Count(SolveMetrics::CacheHits);
+    }
+
+    // gives the solvers the units of variant for puzzles of BoxN, false if it has none of that size.
+    bool Prepare(int BoxN, const std::string& variant);
+
+    // true if a clue is out of range or shares a unit of graph with an equal one.
+    bool Conflicting(const Grid& grid);
+
+    SolveStatus Solve(Engine engine, SolutionCache* cache, const std::string& variant, const Grid& puzzle, SolveResult& result);
+    SolveStatus SolveUncached(Engine engine, int BoxN, SolveResult& result);
+
+    // Solve with the time it took, and records it. seed 0 keeps the random seed.
+    void SolveTimed(Engine engine, SolutionCache* cache, const std::string& variant, uint64_t seed, const Grid& puzzle, SolveResult& result);
+    void SolveLanes(Engine engine, SolutionCache* cache, const std::string& variant, uint64_t seed, const Grid* puzzles, size_t count, SolveResult* results);
+};
+
+// BoxN of a grid with cells cells, 0 if it isn't a square of a square.
+static int BoxSize(size_t cells)
+{
+    for (int BoxN = 1; BoxN <= 8; BoxN++)
+        if ((size_t)BoxN * BoxN * BoxN * BoxN == cells)
+            return BoxN;
+
+    return 0;
+}
+
+bool BatchSolver::Worker::Prepare(int BoxN, const std::string& variant)
+{
+    if (this->BoxN == BoxN && this->variant == variant)
+        return valid;
+
+    this->BoxN = BoxN;
+    this->variant = variant;
+    valid = UnitGraph::Parse(variant, BoxN, graph);
+
+    sudoku.SetUnits(graph);
+    mask.SetUnits(graph);
+    return valid;
+}
+
+bool BatchSolver::Worker::Conflicting(const Grid& grid)
+{
+    int N = graph.Size();
+    placed.assign(graph.UnitCount(), 0);
+
+    for (int cell = 0; cell < (int)grid.size(); cell++)
+    {
+        int num = grid[cell];
+        if (!num)
+            continue;
+        if (num < 0 || num > N)
+            return true;
+
+        uint64_t bit = (uint64_t)1 << (num - 1);
+        for (const int* u = graph.UnitsBegin(cell); u != graph.UnitsEnd(cell); u++)
+        {
+            if (placed[*u] & bit)
+                return true;
+            placed[*u] |= bit;
+        }
+    }
+
+    return false;
+}
+
+SolveStatus BatchSolver::Worker::Solve(Engine engine, SolutionCache* cache, const std::string& variant, const Grid& puzzle, SolveResult& result)
+{
+    int BoxN = BoxSize(puzzle.size());
+
+    result.solution = puzzle;
+    result.nodes = 0;
+    result.cached = false;
+
+    if (!BoxN || !Prepare(BoxN, variant))
+        return SolveStatus::Invalid;
+
+    // the cache only knows the symmetries of a classic board.
+    if (!cache || BoxN != 3 || !graph.Classic())
+        return SolveUncached(engine, BoxN, result);
+
+    if (cache->Lookup(puzzle, result.solution, form))
+    {
+        result.cached = true;
+        return SolveStatus::Solved;
+    }
+
+    // a miss leaves the solution alone.
+    SolveStatus status = SolveUncached(engine, BoxN, result);
+    if (status == SolveStatus::Solved)
+        cache->Insert(form, result.solution);
+
+    return status;
+}
+
+SolveStatus BatchSolver::Worker::SolveUncached(Engine engine, int BoxN, SolveResult& result)
+{
+    typedef std::chrono::steady_clock Clock;
+    int N = BoxN * BoxN;
+    Grid& grid = result.solution;
+
+    // Load of the mask and bitboard engines also fails when propagating the clues empties a cell,
+    // that puzzle is unsolvable, as SudokuSolver finds it in its search. a failed load solves nothing.
+    if (engine == Engine::Bitboard && BoxN == 3 && graph.Classic())
+    {
+        auto start = Clock::now();
+        if (!bitboard.Load(grid) && Conflicting(grid))
+            return SolveStatus::Invalid;
+
+        auto loaded = Clock::now();
+        bool solved = bitboard.Solve();
+        result.nodes = bitboard.NumberOfNodes;
+
+        Count(solved, result.nodes, bitboard.Propagations, std::chrono::duration<double>(loaded - start).count(),
+              std::chrono::duration<double>(Clock::now() - loaded).count());
+
+        if (!solved)
+            return SolveStatus::Unsolvable;
+
+        grid = bitboard.GetSolution();
+        return SolveStatus::Solved;
+    }
+
+    // SudokuSolver has no hidden singles, from 36 * 36 up it can search for hours.
+    if (engine != Engine::Sudoku || BoxN > 5)
+    {
+        auto start = Clock::now();
+        if (!mask.Load(grid) && Conflicting(grid))
+            return SolveStatus::Invalid;
+
+        auto loaded = Clock::now();
+        bool solved = mask.Solve();
+        result.nodes = mask.NumberOfNodes;
+
+        Count(solved, result.nodes, mask.Propagations, std::chrono::duration<double>(loaded - start).count(),
+              std::chrono::duration<double>(Clock::now() - loaded).count());
+
+        if (!solved)
+            return SolveStatus::Unsolvable;
+
+        grid = mask.GetSolution();
+        return SolveStatus::Solved;
+    }
+
+    // loaded in place, a clue that contradicts an earlier one is skipped.
+    if (!sudoku.LoadGrid(grid))
+        return SolveStatus::Invalid;
+
+    if (TimeLimit > 0)
+    {
+        expired = false;
+        deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(TimeLimit));
+    }
+
+    bool solved = sudoku.Solve();
+    result.nodes = sudoku.NumberOfCalls;
+    stats.Add(sudoku.stats);
+
+    if (!solved)
+        return sudoku.Cancelled ? SolveStatus::TimedOut : SolveStatus::Unsolvable;
+
+    // grid has N * N cells already.
+    const Board& cells = sudoku.GetBoard().GetCells();
+    for (int r = 0; r < N; r++)
+        std::copy(cells[r].begin(), cells[r].end(), grid.begin() + r * N);
+
+    return SolveStatus::Solved;
+}
+
+// at most LaneSolver::Lanes puzzles, a lane solves a puzzle in one propagation (one node),
+// the others are solved one by one. the time of the lanes is split among the puzzles.
+void BatchSolver::Worker::SolveLanes(Engine engine, SolutionCache* cache, const std::string& variant, uint64_t seed, const Grid* puzzles, size_t count, SolveResult* results)
+{
+    typedef std::chrono::steady_clock Clock;
+    auto start = Clock::now();
+
+    lanes.Clear();
+    for (size_t i = 0; i < count; i++)
+        lanes.Load((int)i, puzzles[i]);
+
+    uint32_t solved = lanes.Propagate();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count(), share = seconds / count;
+
+    stats.seconds[SolverStats::Propagate] += seconds;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        SolveResult& result = results[i];
+
+        if (solved & (1u << i))
+        {
+            lanes.GetSolution((int)i, result.solution);
+            result.status = SolveStatus::Solved;
+            result.nodes = 1;
+            result.cached = false;
+            result.seconds = share;
+
+            stats.solves++;
+            stats.solved++;
+            stats.nodes++;
+            Record(result);
+            continue;
+        }
+
+        if (seed)
+            sudoku.Seed(seed + i);
+
+        start = Clock::now();
+        result.status = Solve(engine, cache, variant, puzzles[i], result);
+        result.seconds = share + std::chrono::duration<double>(Clock::now() - start).count();
+        Record(result);
+    }
+}
+
+void BatchSolver::Worker::SolveTimed(Engine engine, SolutionCache* cache, const std::string& variant, uint64_t seed, const Grid& puzzle, SolveResult& result)
+{
+    if (seed)
+        sudoku.Seed(seed);
+
+    auto start = std::chrono::steady_clock::now();
+
+    result.status = Solve(engine, cache, variant, puzzle, result);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Record(result);
+}
+
+bool ParseEngine(const std::string& name, Engine& engine)
+{
+    static const char* names[] = { "sudoku", "mask", "bitboard" };
+
+    for (int i = 0; i < 3; i++)
+        if (name == names[i])
+            return engine = (Engine)i, true;
+
+    return false;
+}
+
+BatchSolver::BatchSolver(int threads, Engine engine)
+    : pool(threads), engine(engine), cache(nullptr), lanes(false), seed(0), classic(true)
+{
+    for (int i = 0; i < pool.Size(); i++)
+        workers.emplace_back(new Worker());
+}
+
+BatchSolver::~BatchSolver()
+{
+}
+
+SolverStats BatchSolver::Stats() const
+{
+    SolverStats total;
+
+    for (const auto& worker : workers)
+        total.Add(worker->stats);
+
+    return total;
+}
+
+void BatchSolver::ResetStats()
+{
+    for (auto& worker : workers)
+        worker->stats.Clear();
+}
+
+bool BatchSolver::SetVariant(const std::string& variant)
+{
+    UnitGraph graph;
+    bool parsed = false;
+
+    for (int BoxN = 1; BoxN <= 8 && !parsed; BoxN++)
+        parsed = UnitGraph::Parse(variant, BoxN, graph);
+
+    if (!parsed)
+        return false;
+
+    this->variant = variant;
+    classic = UnitGraph::Parse(variant, 3, graph) && graph.Classic();
+    return true;
+}
+
+void BatchSolver::SetTimeLimit(double seconds)
+{
+    for (auto& worker : workers)
+        worker->TimeLimit = seconds;
+}
+
+void BatchSolver::Metrics(SolveMetrics& total) const
+{
+    for (const auto& worker : workers)
+        total.Merge(worker->metrics);
+}
+
+void BatchSolver::ResetMetrics()
+{
+    for (auto& worker : workers)
+        worker->metrics.Clear();
+}
+
+void BatchSolver::SolveBatch(const Grid* puzzles, size_t count, SolveResult* results)
+{
+    if (lanes && classic)
+    {
+        const size_t group = LaneSolver::Lanes;
+
+        pool.ParallelFor((count + group - 1) / group, [&](int w, size_t g)
+        {
+            size_t first = g * group;
+            workers[w]->SolveLanes(engine, cache, variant, seed ? seed + first : 0, puzzles + first, std::min(group, count - first), results + first);
+        });
+
+        return;
+    }
+
+    pool.ParallelFor(count, [&](int w, size_t i)
+    {
+        workers[w]->SolveTimed(engine, cache, variant, seed ? seed + i : 0, puzzles[i], results[i]);
+    });
+}
+
+void BatchSolver::SolveBatch(const std::vector<Grid>& puzzles, std::vector<SolveResult>& results)
+{
+    results.resize(puzzles.size());
+    SolveBatch(puzzles.data(), puzzles.size(), results.data());
+}
+
+void BatchSolver::SolveChunks(size_t count, const std::function<size_t(size_t, std::vector<Grid>&)>& read,
+                              const std::function<void(size_t, const Grid*, const SolveResult*, size_t)>& write)
+{
+    pool.ParallelFor(count, [&](int w, size_t c)
+    {
+        Worker& worker = *workers[w];
+
+        size_t n = read(c, worker.puzzles);
+        if (worker.results.size() < n)
+            worker.results.resize(n);
+
+        uint64_t first = seed ? seed + ((uint64_t)c << 32) : 0;
+        const size_t group = LaneSolver::Lanes;
+
+        if (lanes && classic)
+        {
+            for (size_t i = 0; i < n; i += group)
+                worker.SolveLanes(engine, cache, variant, first ? first + i : 0, &worker.puzzles[i], std::min(group, n - i), &worker.results[i]);
+        }
+        else
+        {
+            for (size_t i = 0; i < n; i++)
+                worker.SolveTimed(engine, cache, variant, first ? first + i : 0, worker.puzzles[i], worker.results[i]);
+        }
+
+        write(c, worker.puzzles.data(), worker.results.data(), n);
+    });
+}
@@ -0,0 +1,422 @@
+#include "BatchSolver.h"
+#include "BitboardSolver.h"
+#include "PuzzleGenerator.h"
+#include "PuzzlePack.h"
+#include "GridValidator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+
+// solver benchmark.
+// runs every solver configuration over a fixed set of corpora and writes, for each pair,
+// puzzles/s, ns/puzzle, nodes/puzzle and the p50/p99/p999 latencies, as JSON.
+// a summary is written to the standard error, and with --baseline every result is
+// compared with the one of an earlier run.
+//
+// usage: SudokuBench [--corpora dir] [--output file] [--baseline file] [--tolerance percent]
+//                    [--rounds n] [--threads t] [--seed s] [--corpus name] [--config name]
+//   --corpora    where the corpora are, default "bench". a corpus that isn't there
+//                is generated with its fixed seed and written there.
+//   --output     the JSON file, default the standard output.
+//   --baseline   a JSON file of an earlier run. a result is a regression if it is more than
+//                --tolerance percent (default 10) slower, or needs more nodes.
+//   --rounds     every corpus is solved this many times (default 3), the fastest round counts
+//                and the latencies of every round are kept.
+//   --threads    default 1, the latencies are only comparable with the same number.
+//   --seed       the seed of SudokuSolver (see BatchSolver::SetSeed), default 1.
+//   --corpus and --config run only the one with that name.
+// returns 2 if a solution is wrong and 3 if there is a regression.
+// built with CONFIG+=strategies (see SudokuBench.pro) it checks SudokuSolver with its strategies on.
+//
+// the JSON has one result per line, which is all the baseline reader relies on.
+
+static void Usage()
+{
+    std::fprintf(stderr, "usage: SudokuBench [--corpora dir] [--output file] [--baseline file] [--tolerance percent]\n"
+                         "                   [--rounds n] [--threads t] [--seed s] [--corpus name] [--config name]\n");
+}
+
+// a corpus is generated from its seed alone, the files only make it independent of
+// later changes to the generator.
+struct Corpus
+{
+    const char* name;
+    int BoxN;
+    int count;
+    int MinClues, MaxClues;                     // 0 for minimal puzzles.
+    Difficulty MinDifficulty, MaxDifficulty;
+    uint64_t seed;
+};
+
+static const Corpus Corpora[] =
+{
+    { "easy",    3, 1000, 36, 45,   Difficulty::Easy, Difficulty::Easy,   1 },
+    { "hard",    3, 300,  0, 0,     Difficulty::Hard, Difficulty::Expert, 2 },
+    { "minimal", 3, 300,  0, 0,     Difficulty::Easy, Difficulty::Expert, 3 },
+    { "16x16",   4, 50,   120, 130, Difficulty::Easy, Difficulty::Expert, 4 },
+    { "25x25",   5, 10,   380, 400, Difficulty::Easy, Difficulty::Expert, 5 },
+
+    // just above where uniqueness gets expensive to prove (about 57% and 59% of the cells),
+    // fewer clues make the generator, not the solvers, take minutes.
+    { "36x36",   6, 10,   730, 760,   Difficulty::Easy, Difficulty::Expert, 6 },
+    { "49x49",   7, 5,    1420, 1460, Difficulty::Easy, Difficulty::Expert, 7 },
+};
+
+struct Config
+{
+    const char* name;
+    Engine engine;
+    bool lanes;
+    int MaxBoxN;                                // above it the engine is the same as mask (see Engine).
+};
+
+static const Config Configs[] =
+{
+    { "sudoku",         Engine::Sudoku,   false, 5 },
+    { "mask",           Engine::Bitmask,  false, 8 },
+    { "bitboard",       Engine::Bitboard, false, 3 },
+    { "sudoku+lanes",   Engine::Sudoku,   true,  3 },
+    { "bitboard+lanes", Engine::Bitboard, true,  3 },
+};
+
+struct Result
+{
+    std::string corpus, config;
+    size_t puzzles = 0, solved = 0, wrong = 0;
+    double PerSecond = 0, ns = 0, nodes = 0;
+    double p50 = 0, p99 = 0, p999 = 0;          // ns.
+};
+
+static bool Generate(const Corpus& corpus, std::vector<Grid>& puzzles, std::vector<Grid>& solutions)
+{
+    PuzzleGenerator generator(corpus.BoxN, corpus.seed);
+    Xoshiro256 rng(corpus.seed);
+    Grid puzzle, solution;
+    long long tries = 0;
+
+    while ((int)puzzles.size() < corpus.count)
+    {
+        // a corpus that can't be filled is a mistake in the table.
+        if (++tries > 1000LL * corpus.count)
+            return false;
+
+        bool minimal = !corpus.MaxClues;
+        int clues = corpus.MinClues + (int)rng.Bounded(corpus.MaxClues - corpus.MinClues + 1);
+
+        generator.Generate(puzzle, solution, clues, Symmetry::None, minimal);
+
+        Difficulty difficulty = generator.Grade(puzzle);
+        if (difficulty < corpus.MinDifficulty || difficulty > corpus.MaxDifficulty)
+            continue;
+
+        puzzles.push_back(puzzle);
+        solutions.push_back(solution);
+    }
+
+    return true;
+}
+
+// reads dir/name.sdkp, or generates it and writes it there.
+static bool LoadCorpus(const std::string& dir, const Corpus& corpus, std::vector<Grid>& puzzles, std::vector<Grid>& solutions)
+{
+    std::string path = dir + "/" + corpus.name + ".sdkp";
+
+    PuzzlePackReader reader;
+    if (reader.Open(path))
+    {
+        if (reader.BoxSize() != corpus.BoxN || !reader.Solutions())
+            return false;
+
+        puzzles.resize(reader.Count());
+        solutions.resize(reader.Count());
+
+        for (uint64_t i = 0; i < reader.Count(); i++)
+        {
+            reader.Puzzle(i, puzzles[i]);
+            reader.Solution(i, solutions[i]);
+        }
+
+        return true;
+    }
+
+    std::fprintf(stderr, "generating %s\n", path.c_str());
+    if (!Generate(corpus, puzzles, solutions))
+        return false;
+
+    PuzzlePackWriter writer;
+    bool res = writer.Open(path, corpus.BoxN, true);
+    for (size_t i = 0; res && i < puzzles.size(); i++)
+        res = writer.Add(puzzles[i], solutions[i]);
+
+    if (!(res && writer.Close()))
+        std::fprintf(stderr, "%s: can't be written, the corpus is only used for this run\n", path.c_str());
+
+    return true;
+}
+
+// the value at rank p (0..1) of sorted.
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+    return sorted.empty() ? 0 : sorted[(size_t)(p * (sorted.size() - 1))];
+}
+
+static Result Run(BatchSolver& solver, const Config& config, const Corpus& corpus, int rounds,
+                  const std::vector<Grid>& puzzles, const std::vector<Grid>& solutions)
+{
+    Result res;
+    res.corpus = corpus.name;
+    res.config = config.name;
+    res.puzzles = puzzles.size();
+
+    solver.SetEngine(config.engine);
+    solver.SetLanes(config.lanes);
+
+    std::vector<SolveResult> results;
+    std::vector<double> latencies;
+    double best = 0;
+    long long nodes = 0;
+
+    for (int round = 0; round < rounds; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        solver.SolveBatch(puzzles, results);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!round || seconds < best)
+            best = seconds;
+
+        for (const SolveResult& r : results)
+            latencies.push_back(r.seconds * 1e9);
+
+        // with the seed set the nodes are the same in every round.
+        if (!round)
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                nodes += results[i].nodes;
+
+                if (results[i].status == SolveStatus::Solved)
+                {
+                    res.solved++;
+
+                    // the corpora have unique solutions, so any other one is wrong.
+                    if (results[i].solution != solutions[i] || !GridValidator::Validate(results[i].solution, puzzles[i]))
+                        res.wrong++;
+                }
+            }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    if (res.puzzles && best > 0)
+    {
+        res.PerSecond = res.puzzles / best;
+        res.ns = best * 1e9 / res.puzzles;
+        // rounded as it is written, so it compares equal with a baseline.
+        res.nodes = std::round((double)nodes / res.puzzles * 1e4) / 1e4;
+    }
+
+    res.p50 = Percentile(latencies, 0.5);
+    res.p99 = Percentile(latencies, 0.99);
+    res.p999 = Percentile(latencies, 0.999);
+
+    return res;
+}
+
+static void AppendJson(std::string& out, const Result& r)
+{
+    char line[512];
+    std::snprintf(line, sizeof(line),
+        "    {\"corpus\": \"%s\", \"config\": \"%s\", \"puzzles\": %zu, \"solved\": %zu, \"wrong\": %zu, "
+        "\"puzzles_per_second\": %.1f, \"ns_per_puzzle\": %.1f, \"nodes_per_puzzle\": %.4f, "
+        "\"p50_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f}",
+        r.corpus.c_str(), r.config.c_str(), r.puzzles, r.solved, r.wrong,
+        r.PerSecond, r.ns, r.nodes, r.p50, r.p99, r.p999);
+    out += line;
+}
+
+// the value of "key": in line, without the quotes of a string.
+static bool Field(const std::string& line, const char* key, std::string& value)
+{
+    std::string k = std::string("\"") + key + "\":";
+    size_t pos = line.find(k);
+    if (pos == std::string::npos)
+        return false;
+
+    pos = line.find_first_not_of(' ', pos + k.size());
+    if (pos == std::string::npos)
+        return false;
+
+    size_t end = line[pos] == '"' ? line.find('"', ++pos) : line.find_first_of(",}", pos);
+    value = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    return true;
+}
+
+// the results of a JSON file written by this program, by "corpus/config".
+static bool ReadBaseline(const std::string& path, std::map<std::string, Result>& baseline)
+{
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file)
+        return false;
+
+    char buffer[1024];
+    while (std::fgets(buffer, sizeof(buffer), file))
+    {
+        std::string line = buffer, corpus, config, ns, nodes;
+
+        if (!Field(line, "corpus", corpus) || !Field(line, "config", config) ||
+            !Field(line, "ns_per_puzzle", ns) || !Field(line, "nodes_per_puzzle", nodes))
+            continue;
+
+        Result& r = baseline[corpus + "/" + config];
+        r.corpus = corpus;
+        r.config = config;
+        r.ns = std::atof(ns.c_str());
+        r.nodes = std::atof(nodes.c_str());
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string dir = "bench", output, BaselineFile, OnlyCorpus, OnlyConfig;
+    double tolerance = 10;
+    int rounds = 3, threads = 1;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string value = argv[++i];
+
+        if (arg == "--corpora")
+            dir = value;
+        else if (arg == "--output")
+            output = value;
+        else if (arg == "--baseline")
+            BaselineFile = value;
+        else if (arg == "--tolerance")
+            tolerance = std::atof(value.c_str());
+        else if (arg == "--rounds")
+            rounds = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--threads")
+            threads = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--seed")
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--corpus")
+            OnlyCorpus = value;
+        else if (arg == "--config")
+            OnlyConfig = value;
+        else
+            return Usage(), 1;
+    }
+
+    std::map<std::string, Result> baseline;
+    if (!BaselineFile.empty() && !ReadBaseline(BaselineFile, baseline))
+    {
+        std::perror(BaselineFile.c_str());
+        return 1;
+    }
+
+    BatchSolver solver(threads);
+    solver.SetSeed(seed);
+
+    std::vector<Result> results;
+    int wrong = 0, regressions = 0;
+
+    std::fprintf(stderr, "%-8s %-15s %12s %12s %10s %10s %10s %10s\n",
+                 "corpus", "config", "puzzles/s", "ns/puzzle", "nodes", "p50 us", "p99 us", "p999 us");
+
+    for (const Corpus& corpus : Corpora)
+    {
+        if (!OnlyCorpus.empty() && OnlyCorpus != corpus.name)
+            continue;
+
+        std::vector<Grid> puzzles, solutions;
+        if (!LoadCorpus(dir, corpus, puzzles, solutions))
+        {
+            std::fprintf(stderr, "%s/%s.sdkp: not a valid corpus\n", dir.c_str(), corpus.name);
+            return 1;
+        }
+
+        for (const Config& config : Configs)
+        {
+            if ((!OnlyConfig.empty() && OnlyConfig != config.name) || corpus.BoxN > config.MaxBoxN)
+                continue;
+
+            Result r = Run(solver, config, corpus, rounds, puzzles, solutions);
+            results.push_back(r);
+            wrong += r.wrong > 0;
+
+            std::fprintf(stderr, "%-8s %-15s %12.0f %12.0f %10.2f %10.2f %10.2f %10.2f",
+                         r.corpus.c_str(), r.config.c_str(), r.PerSecond, r.ns, r.nodes,
+                         r.p50 * 1e-3, r.p99 * 1e-3, r.p999 * 1e-3);
+
+            if (r.wrong)
+                std::fprintf(stderr, "  %zu WRONG", r.wrong);
+
+            auto base = baseline.find(r.corpus + "/" + r.config);
+            if (base != baseline.end() && base->second.ns > 0)
+            {
+                double change = (r.ns / base->second.ns - 1) * 100;
+                bool slower = change > tolerance;
+
+                // the nodes don't depend on the machine, so any increase is a change of the search.
+                bool MoreNodes = r.nodes > base->second.nodes;
+
+                std::fprintf(stderr, "  %+.1f%%", change);
+                if (r.nodes != base->second.nodes)
+                    std::fprintf(stderr, " nodes %+.2f%%", base->second.nodes > 0 ? (r.nodes / base->second.nodes - 1) * 100 : 100.0);
+                if (slower || MoreNodes)
+                    std::fprintf(stderr, "  REGRESSION");
+
+                regressions += slower || MoreNodes;
+            }
+
+            std::fprintf(stderr, "\n");
+        }
+    }
+
+    std::string json = "{\n  \"kernel\": \"";
+    json += BitboardSolver::KernelName();
+    json += "\",\n  \"threads\": " + std::to_string(threads) + ",\n  \"rounds\": " + std::to_string(rounds) +
+            ",\n  \"seed\": " + std::to_string(seed) + ",\n  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        AppendJson(json, results[i]);
+        json += i + 1 < results.size() ? ",\n" : "\n";
+    }
+
+    json += "  ]\n}\n";
+
+    FILE* out = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+    if (!out)
+    {
+        std::perror(output.c_str());
+        return 1;
+    }
+
+    std::fwrite(json.data(), 1, json.size(), out);
+    if (out != stdout && std::fclose(out) != 0)
+    {
+        std::perror(output.c_str());
+        return 1;
+    }
+
+    if (!baseline.empty())
+        std::fprintf(stderr, "%d of %zu results regressed (tolerance %.0f%%)\n", regressions, results.size(), tolerance);
+
+    return wrong ? 2 : regressions ? 3 : 0;
+}
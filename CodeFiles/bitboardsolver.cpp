@@ -0,0 +1,393 @@
+#include "BitboardSolver.h"
+
+typedef BitboardSolver::Vector Vector;
+typedef BitboardSolver::State State;
+typedef BitboardSolver::Frame Frame;
+
+// everything the kernel calls is inlined into it, so it is compiled for the target of the kernel.
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+static const uint32_t Band = (1u << 27) - 1;
+static const uint32_t BoxBits = 0x7 | 0x7 << 9 | 0x7 << 18;
+
+// cell = band * 27 + row in the band * 9 + column, which is just r * 9 + c.
+static Vector CellBoth[81];						// the bit of the cell in both halves.
+static Vector CellHalf[2][81];					// the bit of the cell in one half.
+static Vector PeersHalf[2][81];					// the peers of the cell in one half.
+
+static struct Tables
+{
+    Tables()
+    {
+        for (int cell = 0; cell < 81; cell++)
+        {
+            int r = cell / 9, c = cell % 9;
+
+            for (int other = 0; other < 81; other++)
+            {
+                int r2 = other / 9, c2 = other % 9;
+                bool peer = other != cell && (r2 == r || c2 == c || (r2 / 3 == r / 3 && c2 / 3 == c / 3));
+
+                for (int h = 0; h < 2; h++)
+                    if (peer)
+                        PeersHalf[h][cell][h * 4 + other / 27] |= 1u << (other % 27);
+            }
+
+            for (int h = 0; h < 2; h++)
+            {
+                CellHalf[h][cell][h * 4 + cell / 27] = 1u << (cell % 27);
+                CellBoth[cell] |= CellHalf[h][cell];
+            }
+        }
+    }
+} tables;
+
+KERNEL_INLINE bool Any(const Vector& v)
+{
+    return (v[0] | v[1] | v[2] | v[4] | v[5] | v[6]) != 0;
+}
+
+// the two halves of v swapped (an out parameter, a vector return value has no fixed ABI without AVX).
+KERNEL_INLINE void Swap(const Vector& v, Vector& out)
+{
+    const Vector order = { 4, 5, 6, 7, 0, 1, 2, 3 };
+    out = __builtin_shuffle(v, order);
+}
+
+KERNEL_INLINE uint32_t& Lane(Vector* planes, int d, int band)
+{
+    return planes[d >> 1][(d & 1) * 4 + band];
+}
+
+KERNEL_INLINE bool Place(State& st, int d, int cell)
+{
+    if (!(Lane(st.planes, d, cell / 27) & (1u << (cell % 27))))
+        return false;
+
+    for (int p = 0; p < 5; p++)
+        st.planes[p] &= ~CellBoth[cell];
+
+    st.planes[d >> 1] &= ~PeersHalf[d & 1][cell];
+    st.placed[d >> 1] |= CellHalf[d & 1][cell];
+    st.unsolved &= ~CellBoth[cell];
+
+    return true;
+}
+
+// the candidates of cell, bit d for d + 1.
+KERNEL_INLINE uint32_t CellCandidates(const State& st, int cell)
+{
+    uint32_t bit = 1u << (cell % 27), res = 0;
+    int band = cell / 27;
+
+    for (int d = 0; d < 9; d++)
+        if (st.planes[d >> 1][(d & 1) * 4 + band] & bit)
+            res |= 1u << d;
+
+    return res;
+}
+
+// cells with at least one, two and three candidates, in both halves.
+KERNEL_INLINE void CountCandidates(const State& st, Vector& one, Vector& two, Vector& three)
+{
+    Vector a1 = { 0 }, a2 = { 0 }, a3 = { 0 };
+
+    for (int p = 0; p < 5; p++)
+    {
+        a3 |= a2 & st.planes[p];
+        a2 |= a1 & st.planes[p];
+        a1 |= st.planes[p];
+    }
+
+    Vector s1, s2, s3;
+    Swap(a1, s1);
+    Swap(a2, s2);
+    Swap(a3, s3);
+
+    one = a1 | s1;
+    two = a2 | s2 | (a1 & s1);
+    three = a3 | s3 | (a2 & s1) | (a1 & s2);
+}
+
+// the hidden singles of the two digits of one plane vector, for all 27 units at once:
+// cells gets the cells where a digit has to go, because no other cell of a row, column or box can take it.
+// false if a unit that still needs a digit has no cell left for it.
+KERNEL_INLINE bool HiddenSingles(const Vector& x, const Vector& s, const Vector& valid, Vector& cells)
+{
+    const Vector next = { 1, 2, 0, 3, 5, 6, 4, 7 }, after = { 2, 0, 1, 3, 6, 4, 5, 7 };
+    const Vector zero = { 0 };
+    Vector empty = zero, ones = zero, twos = zero, done = zero;
+
+    cells = zero;
+
+    for (int k = 0; k < 3; k++)
+    {
+        Vector row = (x >> (9 * k)) & 511, RowOpen = (Vector)(((s >> (9 * k)) & 511) == zero);
+        Vector box = x & (BoxBits << (3 * k)), BoxOpen = (Vector)((s & (BoxBits << (3 * k))) == zero);
+
+        // a unit with one bit left is that bit, one with none is a contradiction.
+        cells |= (row & (Vector)((row & (row - 1)) == zero) & RowOpen) << (9 * k);
+        cells |= box & (Vector)((box & (box - 1)) == zero) & BoxOpen;
+        empty |= ((Vector)(row == zero) & RowOpen) | ((Vector)(box == zero) & BoxOpen);
+
+        // the rows are added up as nine bit columns.
+        twos |= ones & row;
+        ones |= row;
+        done |= (s >> (9 * k)) & 511;
+    }
+
+    // the columns add up the three bands of each half.
+    Vector o1 = __builtin_shuffle(ones, next), o2 = __builtin_shuffle(ones, after);
+    Vector t = twos | __builtin_shuffle(twos, next) | __builtin_shuffle(twos, after) | (ones & o1) | (ones & o2) | (o1 & o2);
+    Vector o = ones | o1 | o2;
+    Vector d = done | __builtin_shuffle(done, next) | __builtin_shuffle(done, after);
+    Vector column = o & ~t;
+
+    cells |= x & (column | column << 9 | column << 18);
+    empty |= ~(o | d) & 511;
+
+    cells &= valid;
+    return !Any(empty & valid);
+}
+
+// naked and hidden singles until none are left, false on a contradiction.
+KERNEL_INLINE bool Propagate(State& st, long long* propagations)
+{
+    while (true)
+    {
+        Vector one, two, three;
+        CountCandidates(st, one, two, three);
+
+        if (Any(st.unsolved & ~one))
+            return false;
+
+        Vector single = st.unsolved & one & ~two;
+        if (Any(single))
+        {
+            for (int b = 0; b < 3; b++)
+                for (uint32_t bits = single[b]; bits; bits &= bits - 1)
+                {
+                    int cell = b * 27 + __builtin_ctz(bits);
+
+                    // an earlier single may have taken the last candidate.
+                    uint32_t cand = CellCandidates(st, cell);
+                    if (!cand || !Place(st, __builtin_ctz(cand), cell))
+                        return false;
+
+                    ++propagations[SolverStats::NakedSingles];
+                }
+
+            continue;
+        }
+
+        // every hidden single of every digit, then the naked singles they made.
+        const Vector pair = { ~0u, ~0u, ~0u, 0, ~0u, ~0u, ~0u, 0 }, last = { ~0u, ~0u, ~0u, 0, 0, 0, 0, 0 };
+        bool found = false;
+
+        for (int p = 0; p < 5; p++)
+        {
+            Vector cells;
+            if (!HiddenSingles(st.planes[p], st.placed[p], p == 4 ? last : pair, cells))
+                return false;
+
+            if (!Any(cells))
+                continue;
+
+            found = true;
+
+            // a cell that lost the digit to an earlier single leaves its unit without it.
+            for (int h = 0; h < 2; h++)
+                for (int b = 0; b < 3; b++)
+                    for (uint32_t bits = cells[h * 4 + b]; bits; bits &= bits - 1)
+                    {
+                        if (!Place(st, 2 * p + h, b * 27 + __builtin_ctz(bits)))
+                            return false;
+
+                        ++propagations[SolverStats::HiddenSingles];
+                    }
+        }
+
+        if (!found)
+            return true;
+    }
+}
+
+// the cell to branch on: one with two candidates if there is one, else the one with the fewest.
+// -1 if the board is solved.
+KERNEL_INLINE int Choose(const State& st)
+{
+    Vector one, two, three;
+    CountCandidates(st, one, two, three);
+
+    Vector pair = st.unsolved & two & ~three;
+    for (int b = 0; b < 3; b++)
+        if (pair[b])
+            return b * 27 + __builtin_ctz(pair[b]);
+
+    int best = -1, fewest = 10;
+    for (int b = 0; b < 3; b++)
+        for (uint32_t bits = st.unsolved[b]; bits; bits &= bits - 1)
+        {
+            int cell = b * 27 + __builtin_ctz(bits);
+            int n = __builtin_popcount(CellCandidates(st, cell));
+
+            if (n < fewest)
+            {
+                fewest = n;
+                best = cell;
+            }
+        }
+
+    return best;
+}
+
+KERNEL_INLINE void Write(const State& st, Grid& solution)
+{
+    solution.assign(81, 0);
+
+    for (int d = 0; d < 9; d++)
+        for (int b = 0; b < 3; b++)
+            for (uint32_t bits = st.placed[d >> 1][(d & 1) * 4 + b]; bits; bits &= bits - 1)
+                solution[b * 27 + __builtin_ctz(bits)] = d + 1;
+}
+
+// depth first search without recursion, stack[0].state is the loaded board.
+KERNEL_INLINE int Search(Frame* stack, int limit, long long& nodes, long long* propagations, Grid& solution)
+{
+    int count = 0, depth = 0;
+    bool descend = true;
+
+    nodes = 1;
+    if (!Propagate(stack[0].state, propagations))
+        return 0;
+
+    while (depth >= 0)
+    {
+        Frame& f = stack[depth];
+
+        if (descend)
+        {
+            f.cell = Choose(f.state);
+
+            if (f.cell < 0)
+            {
+                if (++count == 1)
+                    Write(f.state, solution);
+                if (count >= limit)
+                    return count;
+
+                depth--;
+                descend = false;
+                continue;
+            }
+
+            f.left = CellCandidates(f.state, f.cell);
+        }
+
+        if (!f.left)
+        {
+            depth--;
+            descend = false;
+            continue;
+        }
+
+        int d = __builtin_ctz(f.left);
+        f.left &= f.left - 1;
+
+        Frame& child = stack[depth + 1];
+        child.state = f.state;
+        nodes++;
+
+        descend = Place(child.state, d, f.cell) && Propagate(child.state, propagations);
+        if (descend)
+            depth++;
+    }
+
+    return count;
+}
+
+static int SearchGeneric(Frame* stack, int limit, long long& nodes, long long* propagations, Grid& solution)
+{
+    return Search(stack, limit, nodes, propagations, solution);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static int SearchAvx2(Frame* stack, int limit, long long& nodes, long long* propagations, Grid& solution)
+{
+    return Search(stack, limit, nodes, propagations, solution);
+}
+
+static bool HasAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+static bool HasAvx2()
+{
+    return false;
+}
+
+#endif
+
+const char* BitboardSolver::KernelName()
+{
+    return HasAvx2() ? "avx2" : "generic";
+}
+
+BitboardSolver::BitboardSolver()
+    : memory(83 * sizeof(Frame) + 32), loaded(false), kernel(SearchGeneric), NumberOfNodes(0)
+{
+    stack = (Frame*)(((uintptr_t)memory.data() + 31) & ~(uintptr_t)31);
+    root = &stack[82].state;
+    std::fill(Propagations, Propagations + SolverStats::Strategies, 0);
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (HasAvx2())
+        kernel = SearchAvx2;
+#endif
+}
+
+bool BitboardSolver::Load(const Grid& grid)
+{
+    loaded = false;
+
+    if (grid.size() != 81)
+        return false;
+
+    const Vector full = { Band, Band, Band, 0, Band, Band, Band, 0 };
+    const Vector low = { Band, Band, Band, 0, 0, 0, 0, 0 };
+
+    for (int p = 0; p < 5; p++)
+    {
+        root->planes[p] = p < 4 ? full : low;
+        root->placed[p] = Vector{ 0 };
+    }
+    root->unsolved = full;
+
+    for (int cell = 0; cell < 81; cell++)
+    {
+        if (grid[cell] < 0 || grid[cell] > 9)
+            return false;
+        if (grid[cell] && !Place(*root, grid[cell] - 1, cell))
+            return false;
+    }
+
+    return loaded = true;
+}
+
+int BitboardSolver::CountSolutions(int limit)
+{
+    NumberOfNodes = 0;
+    std::fill(Propagations, Propagations + SolverStats::Strategies, 0);
+
+    if (!loaded)
+        return 0;
+
+    stack[0].state = *root;
+    return kernel(stack, limit, NumberOfNodes, Propagations, solution);
+}
@@ -0,0 +1,440 @@
+#include "Canonical.h"
+#include <algorithm>
+#include <cstring>
+
+static const int Perms[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+
+static int PermIndex(int a, int b, int c)
+{
+    int i = 0;
+    while (Perms[i][0] != a || Perms[i][1] != b || Perms[i][2] != c)
+        i++;
+
+    return i;
+}
+
+Canonicalizer::Canonicalizer()
+{
+    // stack order, then the order inside each of the three stacks.
+    for (int s = 0; s < 6; s++)
+        for (int a = 0; a < 6; a++)
+            for (int b = 0; b < 6; b++)
+                for (int c = 0; c < 6; c++)
+                {
+                    int inner[3] = { a, b, c };
+                    std::array<uint8_t, 9> map;
+
+                    for (int j = 0; j < 9; j++)
+                        map[j] = Perms[s][j / 3] * 3 + Perms[inner[j / 3]][j % 3];
+
+                    ColumnMaps.push_back(map);
+                }
+}
+
+bool Canonicalizer::Canonicalize(const Grid& grid, CanonicalForm& form)
+{
+    if (grid.size() != 81)
+        return false;
+
+    // both orientations, so a transposition is just a choice of source.
+    uint8_t source[2][81];
+    for (int r = 0; r < 9; r++)
+        for (int c = 0; c < 9; c++)
+            source[0][r * 9 + c] = source[1][c * 9 + r] = grid[r * 9 + c];
+
+    form.grid.assign(81, 0);
+    next.clear();
+
+    uint8_t row[9];
+    std::memset(best, 0xFF, sizeof(best));
+
+    int first = 1;
+    if (Complete(source))
+    {
+        // every placement turns the first row into 123456789.
+        SearchSecondRow(source);
+
+        for (int j = 0; j < 9; j++)
+        {
+            form.grid[j] = j + 1;
+            form.grid[9 + j] = best[j];
+        }
+
+        Merge(2);
+        first = 2;
+    }
+    else
+    {
+        // the first row is searched over the column maps directly, they are ordered so that
+        // maps sharing their first stack (or first two stacks) are consecutive, and a prefix
+        // that is already bigger skips the whole block.
+        for (int t = 0; t < 2; t++)
+            for (int r = 0; r < 9; r++)
+            {
+                const uint8_t* line = source[t] + r * 9;
+
+                for (int p = 0; p < (int)ColumnMaps.size(); )
+                {
+                    const uint8_t* map = ColumnMaps[p].data();
+                    uint8_t label[10] = { 0 }, last = 0;
+
+                    int order = 0, j = 0;
+                    for (; j < 9; j++)
+                    {
+                        uint8_t v = line[map[j]];
+                        if (v && !label[v])
+                            label[v] = ++last;
+
+                        row[j] = label[v];
+
+                        if (!order)
+                        {
+                            if (row[j] > best[j])
+                                break;
+                            if (row[j] < best[j])
+                                order = -1;
+                        }
+                    }
+
+                    if (j < 9)
+                    {
+                        // 216 maps share the stack order, 36 the first inner order, 6 the second.
+                        p = j < 3 ? p / 36 * 36 + 36 : j < 6 ? p / 6 * 6 + 6 : p + 1;
+                        continue;
+                    }
+
+                    if (order == -1)
+                    {
+                        std::memcpy(best, row, sizeof(best));
+                        next.clear();
+                    }
+
+                    Partial partial;
+                    partial.transpose = t;
+                    partial.columns = p;
+                    partial.rows[0] = r;
+                    partial.next = last;
+                    std::memcpy(partial.label, label, sizeof(label));
+                    next.push_back(partial);
+
+                    p++;
+                }
+            }
+
+        for (int j = 0; j < 9; j++)
+            form.grid[j] = best[j];
+    }
+
+    std::swap(current, next);
+
+    for (int k = first; k < 9; k++)
+    {
+        std::memset(best, 0xFF, sizeof(best));
+        next.clear();
+
+        for (const Partial& partial : current)
+        {
+            const uint8_t* src = source[partial.transpose];
+            const uint8_t* map = ColumnMaps[partial.columns].data();
+
+            // rows that can be placed at k: a row of a new band at the start of a band,
+            // otherwise an unused row of the same band.
+            int band = -1;
+            bool UsedBand[3] = { false, false, false }, UsedRow[9] = { false };
+            for (int i = 0; i < k; i++)
+                UsedBand[partial.rows[i] / 3] = UsedRow[partial.rows[i]] = true;
+
+            if (k % 3)
+                band = partial.rows[k - 1] / 3;
+
+            for (int r = 0; r < 9; r++)
+            {
+                if (UsedRow[r] || (band == -1 ? UsedBand[r / 3] : r / 3 != band))
+                    continue;
+
+                Partial extended = partial;
+                const uint8_t* line = src + r * 9;
+
+                // -1 = already smaller than best, 0 = equal so far.
+                int order = 0;
+                int j = 0;
+                for (; j < 9; j++)
+                {
+                    uint8_t v = line[map[j]];
+                    if (v && !extended.label[v])
+                        extended.label[v] = ++extended.next;
+
+                    row[j] = extended.label[v];
+
+                    if (!order)
+                    {
+                        if (row[j] > best[j])
+                            break;
+                        if (row[j] < best[j])
+                            order = -1;
+                    }
+                }
+
+                // bigger than best.
+                if (j < 9)
+                    continue;
+
+                if (order == -1)
+                {
+                    std::memcpy(best, row, sizeof(best));
+                    next.clear();
+                }
+
+                extended.rows[k] = r;
+                next.push_back(extended);
+            }
+        }
+
+        for (int j = 0; j < 9; j++)
+            form.grid[k * 9 + j] = best[j];
+
+        Merge(k + 1);
+        std::swap(current, next);
+    }
+
+    // every partial left gives the same board, the first one is taken.
+    const Partial& p = current.front();
+
+    std::vector<int> rows(p.rows, p.rows + 9), columns(ColumnMaps[p.columns].begin(), ColumnMaps[p.columns].end());
+    std::vector<int> numbers(10, 0);
+
+    // values that never appear (in puzzles) get the labels left, in order.
+    int label = p.next;
+    for (int v = 1; v <= 9; v++)
+        numbers[v] = p.label[v] ? p.label[v] : ++label;
+
+    // rows of the transposed source are columns of the original one.
+    form.transform = p.transpose ? SudokuTransform(3, true, columns, rows, numbers)
+                                 : SudokuTransform(3, false, rows, columns, numbers);
+    form.hash = HashGrid(form.grid);
+
+    return true;
+}
+
+bool Canonicalizer::Complete(const uint8_t source[2][81])
+{
+    // every row and column holds 1 to 9.
+    for (int t = 0; t < 2; t++)
+        for (int r = 0; r < 9; r++)
+        {
+            int seen = 0;
+            for (int c = 0; c < 9; c++)
+            {
+                uint8_t v = source[t][r * 9 + c];
+                if (!v || v > 9)
+                    return false;
+
+                seen |= 1 << v;
+            }
+
+            if (seen != 0x3FE)
+                return false;
+        }
+
+    return true;
+}
+
+void Canonicalizer::SearchSecondRow(const uint8_t source[2][81])
+{
+    // with the first row fixed, the labels follow the column map, and the second row holds
+    // at each position the new position of the column that has its value in the first row.
+    // so the map is built position by position: a column taken at j puts the column it
+    // follows at the first open position of its block, the only choice that keeps j smallest,
+    // and just the columns taken at open positions are branched on.
+    Placement open;
+    std::memset(&open, -1, sizeof(open));
+
+    for (int t = 0; t < 2; t++)
+        for (int r = 0; r < 9; r++)
+            for (int r2 = r / 3 * 3; r2 < r / 3 * 3 + 3; r2++)
+            {
+                if (r2 == r)
+                    continue;
+
+                top = source[t] + r * 9;
+                const uint8_t* line = source[t] + r2 * 9;
+
+                int column[10];
+                for (int c = 0; c < 9; c++)
+                    column[top[c]] = c;
+                for (int c = 0; c < 9; c++)
+                    follow[c] = column[line[c]];
+
+                base.transpose = t;
+                base.rows[0] = r;
+                base.rows[1] = r2;
+                base.label[0] = 0;
+                base.next = 9;
+
+                Place(open, 0);
+            }
+}
+
+void Canonicalizer::Place(const Placement& placement, int j)
+{
+    if (j == 9)
+    {
+        int order = std::memcmp(placement.row, best, sizeof(best));
+        if (order > 0)
+            return;
+
+        if (order < 0)
+        {
+            std::memcpy(best, placement.row, sizeof(best));
+            next.clear();
+        }
+
+        Partial partial = base;
+
+        // the index of the map in ColumnMaps, see the constructor.
+        const int8_t* map = placement.columns;
+        partial.columns = PermIndex(map[0] / 3, map[3] / 3, map[6] / 3);
+        for (int b = 0; b < 3; b++)
+            partial.columns = partial.columns * 6 + PermIndex(map[b * 3] % 3, map[b * 3 + 1] % 3, map[b * 3 + 2] % 3);
+
+        for (int i = 0; i < 9; i++)
+            partial.label[top[map[i]]] = i + 1;
+
+        next.push_back(partial);
+        return;
+    }
+
+    if (placement.columns[j] != -1)
+    {
+        Placement taken = placement;
+        Follow(taken, j);
+        return;
+    }
+
+    // an open position takes any open column of the stack of its block, or of any stack
+    // not placed yet.
+    int b = j / 3;
+    for (int s = 0; s < 3; s++)
+    {
+        if (placement.stack[b] == -1 ? placement.block[s] != -1 : placement.stack[b] != s)
+            continue;
+
+        for (int c = s * 3; c < s * 3 + 3; c++)
+        {
+            if (placement.position[c] != -1)
+                continue;
+
+            Placement chosen = placement;
+            chosen.stack[b] = s;
+            chosen.block[s] = b;
+            chosen.columns[j] = c;
+            chosen.position[c] = j;
+
+            Follow(chosen, j);
+        }
+    }
+}
+
+void Canonicalizer::Follow(Placement& placement, int j)
+{
+    int x = follow[placement.columns[j]];
+
+    if (placement.position[x] == -1)
+    {
+        int s = x / 3;
+        if (placement.block[s] == -1)
+        {
+            int b = 0;
+            while (placement.stack[b] != -1)
+                b++;
+
+            placement.stack[b] = s;
+            placement.block[s] = b;
+        }
+
+        int slot = placement.block[s] * 3;
+        while (placement.columns[slot] != -1)
+            slot++;
+
+        placement.columns[slot] = x;
+        placement.position[x] = slot;
+    }
+
+    placement.row[j] = placement.position[x] + 1;
+
+    // best may have changed since this branch was compared, so the whole prefix is.
+    for (int i = 0; i <= j; i++)
+        if (placement.row[i] != best[i])
+        {
+            if (placement.row[i] > best[i])
+                return;
+            break;
+        }
+
+    Place(placement, j + 1);
+}
+
+void Canonicalizer::Merge(int rows)
+{
+    // partials with the same orientation, columns, rows used and labels go on the same way,
+    // whatever the order their rows were taken in, so one of them is enough. few partials
+    // cost less to extend than to sort.
+    if (next.size() < 64)
+        return;
+
+    keys.clear();
+    for (uint32_t i = 0; i < next.size(); i++)
+    {
+        const Partial& p = next[i];
+
+        int used = 0;
+        for (int k = 0; k < rows; k++)
+            used |= 1 << p.rows[k];
+
+        uint64_t key = (uint64_t)p.transpose << 11 | p.columns;
+        key = key << 9 | used;
+        for (int v = 1; v <= 9; v++)
+            key = key << 4 | p.label[v];
+
+        keys.push_back(std::make_pair(key, i));
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    current.clear();
+    for (size_t i = 0; i < keys.size(); i++)
+        if (!i || keys[i].first != keys[i - 1].first)
+            current.push_back(next[keys[i].second]);
+
+    std::swap(current, next);
+}
+
+bool Canonicalizer::Canonicalize(const Board& board, CanonicalForm& form)
+{
+    return Canonicalize(ToGrid(board, 9), form);
+}
+
+uint64_t Canonicalizer::Hash(const Grid& grid)
+{
+    CanonicalForm form;
+    return Canonicalize(grid, form) ? form.hash : HashGrid(grid);
+}
+
+uint64_t Canonicalizer::Hash(const Board& board)
+{
+    return Hash(ToGrid(board, 9));
+}
+
+uint64_t Canonicalizer::HashGrid(const Grid& grid)
+{
+    // FNV-1a, then a final mix so close boards don't get close hashes.
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (int v : grid)
+        h = (h ^ (uint64_t)v) * 0x100000001B3ULL;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+
+    return h;
+}
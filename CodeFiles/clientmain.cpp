@@ -0,0 +1,190 @@
+#include "SolverProtocol.h"
+#include "MappedFile.h"
+#include "PuzzleIO.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// a client of SudokuServer, writes the same lines as SudokuBatch ("solution status").
+// puzzles are sent while the responses are read, with at most --window requests in flight.
+//
+// usage: SudokuClient [--socket path] [--input file] [--output file] [--window n]
+
+static const char* StatusNames[] = { "solved", "unsolvable", "invalid", "timeout" };
+
+static void Usage()
+{
+    std::fprintf(stderr, "usage: SudokuClient [--socket path] [--input file] [--output file] [--window n]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    std::string path = "/tmp/sudoku.sock", input = "-", output;
+    long long window = 1024;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string value = argv[++i];
+
+        if (arg == "--socket")
+            path = value;
+        else if (arg == "--input")
+            input = value;
+        else if (arg == "--output")
+            output = value;
+        else if (arg == "--window")
+            window = std::max(1LL, std::atoll(value.c_str()));
+        else
+            return Usage(), 1;
+    }
+
+    MappedFile file;
+    if (!file.Open(input))
+    {
+        std::perror(input.c_str());
+        return 1;
+    }
+
+    int fd = SolverProtocol::Connect(path);
+    if (fd < 0)
+    {
+        std::perror(path.c_str());
+        return 1;
+    }
+
+    FILE* out = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+    if (!out)
+    {
+        std::perror(output.c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::mutex m;
+    std::condition_variable answered;
+    long long sent = 0, received = 0;
+    bool finished = false;
+
+    // sends the lines in frames, a few KB per send.
+    std::thread sender([&]
+    {
+        const char* begin = file.Data();
+        const char* end = begin + file.Size();
+        std::string frames;
+
+        auto Flush = [&]
+        {
+            bool res = SolverProtocol::WriteAll(fd, frames.data(), frames.size());
+            frames.clear();
+            return res;
+        };
+
+        while (begin < end)
+        {
+            const char* newline = (const char*)std::memchr(begin, '\n', end - begin);
+            if (!newline)
+                newline = end;
+
+            const char* line = begin;
+            size_t length = 0;
+            while (line + length < newline && line[length] != ' ' && line[length] != '\t' && line[length] != '\r')
+                length++;
+
+            begin = newline + 1;
+
+            if (!length || PuzzleIO::Comment(line, length))
+                continue;
+
+            // a longer line can't be a puzzle, it's cut so the server answers invalid instead of closing.
+            length = std::min(length, SolverProtocol::MaxBody);
+
+            {
+                std::unique_lock<std::mutex> lock(m);
+
+                // the window is full, what is buffered has to go out before a response can come.
+                if (sent - received >= window)
+                {
+                    lock.unlock();
+                    if (!Flush())
+                        break;
+                    lock.lock();
+
+                    answered.wait(lock, [&] { return finished || sent - received < window; });
+                }
+
+                if (finished)
+                    break;
+
+                sent++;
+            }
+
+            SolverProtocol::AppendFrame(frames, (uint32_t)sent, SolverProtocol::Request, line, length);
+
+            if (frames.size() >= (1 << 14) && !Flush())
+                break;
+        }
+
+        Flush();
+
+        // tells the server there is nothing more, the responses keep coming.
+        shutdown(fd, SHUT_WR);
+    });
+
+    FrameReader reader(fd);
+    long long count[4] = { 0, 0, 0, 0 };
+    uint32_t id;
+    uint8_t code;
+    const char* body;
+    size_t length;
+    std::string text;
+
+    while (reader.Next(id, code, body, length))
+    {
+        if (code > 3)
+            break;
+
+        text.assign(body, length);
+        text += ' ';
+        text += StatusNames[code];
+        text += '\n';
+        std::fwrite(text.data(), 1, text.size(), out);
+        count[code]++;
+
+        std::lock_guard<std::mutex> lock(m);
+        received++;
+        answered.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        finished = true;
+        answered.notify_all();
+    }
+
+    sender.join();
+    close(fd);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!output.empty())
+        std::fclose(out);
+
+    std::fprintf(stderr, "%lld puzzles: %lld solved, %lld unsolvable, %lld invalid, %lld timeout\n",
+                 received, count[0], count[1], count[2], count[3]);
+    std::fprintf(stderr, "%.3f s, %.1f puzzles/s\n", seconds, received / std::max(seconds, 1e-9));
+
+    return received == sent ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "CompactBoard.h"
+#include <algorithm>
+
+static const uint16_t AllCandidates = (1 << CompactBoard::N) - 1;
+
+// the 20 peers and the units of every cell.
+struct CompactPeers
+{
+    uint8_t peers[CompactBoard::Cells][20];
+    uint8_t row[CompactBoard::Cells], column[CompactBoard::Cells], box[CompactBoard::Cells];
+
+    CompactPeers()
+    {
+        for (int cell = 0; cell < CompactBoard::Cells; cell++)
+        {
+            row[cell] = cell / 9;
+            column[cell] = cell % 9;
+            box[cell] = row[cell] / 3 * 3 + column[cell] / 3;
+        }
+
+        for (int cell = 0; cell < CompactBoard::Cells; cell++)
+        {
+            int n = 0;
+            for (int other = 0; other < CompactBoard::Cells; other++)
+                if (other != cell && (row[other] == row[cell] || column[other] == column[cell] || box[other] == box[cell]))
+                    peers[cell][n++] = other;
+        }
+    }
+};
+
+static const CompactPeers tables;
+
+void CompactBoard::Clear()
+{
+    std::fill(cells, cells + Cells, 0);
+    filled = 0;
+    std::fill(candidates, candidates + Cells, AllCandidates);
+    std::fill(rows, rows + N, 0);
+    std::fill(columns, columns + N, 0);
+    std::fill(boxes, boxes + N, 0);
+}
+
+bool CompactBoard::Load(const Grid& grid)
+{
+    Clear();
+
+    if (grid.size() != (size_t)Cells)
+        return false;
+
+    for (int cell = 0; cell < Cells; cell++)
+        if (grid[cell] && (grid[cell] > N || !SetCell(cell, grid[cell])))
+            return false;
+
+    return true;
+}
+
+void CompactBoard::GetGrid(Grid& grid) const
+{
+    grid.assign(cells, cells + Cells);
+}
+
+bool CompactBoard::SetCell(int cell, int num)
+{
+    if (cells[cell] || !isCandidate(cell, num))
+        return false;
+
+    uint16_t bit = 1 << (num - 1);
+
+    cells[cell] = num;
+    filled++;
+    rows[tables.row[cell]] |= bit;
+    columns[tables.column[cell]] |= bit;
+    boxes[tables.box[cell]] |= bit;
+
+    candidates[cell] &= ~bit;
+    for (uint8_t peer : tables.peers[cell])
+        candidates[peer] &= ~bit;
+
+    return true;
+}
+
+bool CompactBoard::UnsetCell(int cell)
+{
+    if (!cells[cell])
+        return false;
+
+    int num = cells[cell];
+    uint16_t bit = 1 << (num - 1);
+
+    cells[cell] = 0;
+    filled--;
+    rows[tables.row[cell]] &= ~bit;
+    columns[tables.column[cell]] &= ~bit;
+    boxes[tables.box[cell]] &= ~bit;
+
+    AddCandidate(cell, num);
+    for (uint8_t peer : tables.peers[cell])
+        AddCandidate(peer, num);
+
+    return true;
+}
+
+bool CompactBoard::AddCandidate(int cell, int num)
+{
+    uint16_t bit = 1 << (num - 1);
+
+    if ((candidates[cell] & bit) || ((rows[tables.row[cell]] | columns[tables.column[cell]] | boxes[tables.box[cell]]) & bit))
+        return false;
+
+    candidates[cell] |= bit;
+    return true;
+}
+
+bool CompactBoard::DeleteCandidate(int cell, int num)
+{
+    uint16_t bit = 1 << (num - 1);
+
+    if (!(candidates[cell] & bit))
+        return false;
+
+    candidates[cell] &= ~bit;
+    return true;
+}
+
+bool CompactBoard::Possible() const
+{
+    for (int cell = 0; cell < Cells; cell++)
+        if (!cells[cell] && !candidates[cell])
+            return false;
+
+    return true;
+}
+
+int CompactBoard::NextCell() const
+{
+    int best = -1, fewest = N + 1;
+
+    for (int cell = 0; cell < Cells && fewest > 1; cell++)
+        if (!cells[cell] && CandidateCount(cell) < fewest)
+            best = cell, fewest = CandidateCount(cell);
+
+    return best;
+}
@@ -0,0 +1,156 @@
+#include "BatchGenerator.h"
+#include "PuzzleIO.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+// headless batch generator, writes one puzzle per line in the line format.
+//
+// usage: SudokuGenerator [options]
+//   --count n            number of puzzles (default 1).
+//   --box b              box size, the board is b^2 * b^2 (default 3).
+//   --clues min[-max]    range of clues to keep.
+//   --difficulty a[-b]   easy, medium, hard, expert.
+//   --symmetry s         none, rotational, mirror, diagonal.
+//   --seed s             the same seed gives the same puzzles (default 0).
+//   --threads t          worker threads (default: all cores).
+//   --solutions          write the solution after each puzzle.
+//   --dedup              skip puzzles equivalent to an earlier one (9 * 9 only).
+//   --output file        default: standard output.
+
+static void Usage()
+{
+    std::fprintf(stderr,
+        "usage: SudokuGenerator [--count n] [--box b] [--clues min[-max]] [--difficulty a[-b]]\n"
+        "                       [--symmetry none|rotational|mirror|diagonal] [--seed s]\n"
+        "                       [--threads t] [--solutions] [--dedup] [--output file]\n");
+}
+
+static bool ParseDifficulty(const std::string& s, Difficulty& d)
+{
+    static const char* names[] = { "easy", "medium", "hard", "expert" };
+
+    for (int i = 0; i < 4; i++)
+        if (s == names[i])
+            return d = (Difficulty)i, true;
+
+    return false;
+}
+
+static bool ParseSymmetry(const std::string& s, Symmetry& symmetry)
+{
+    static const char* names[] = { "none", "rotational", "mirror", "diagonal" };
+
+    for (int i = 0; i < 4; i++)
+        if (s == names[i])
+            return symmetry = (Symmetry)i, true;
+
+    return false;
+}
+
+// "a-b" or "a" (then b = a).
+static void SplitRange(const std::string& s, std::string& a, std::string& b)
+{
+    size_t dash = s.find('-');
+    a = s.substr(0, dash);
+    b = dash == std::string::npos ? a : s.substr(dash + 1);
+}
+
+int main(int argc, char* argv[])
+{
+    GeneratorOptions options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    bool solutions = false, ClueRange = false;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i], a, b;
+
+        if (arg == "--solutions")
+        {
+            solutions = true;
+            continue;
+        }
+
+        if (arg == "--dedup")
+        {
+            options.deduplicate = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string value = argv[++i];
+
+        if (arg == "--count")
+            options.count = std::atoll(value.c_str());
+        else if (arg == "--box")
+            options.BoxN = std::atoi(value.c_str());
+        else if (arg == "--seed")
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--threads")
+            options.threads = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--output")
+            path = argv[i];
+        else if (arg == "--clues")
+        {
+            SplitRange(value, a, b);
+            options.MinClues = std::atoi(a.c_str());
+            options.MaxClues = std::atoi(b.c_str());
+            ClueRange = true;
+        }
+        else if (arg == "--difficulty")
+        {
+            SplitRange(value, a, b);
+            if (!ParseDifficulty(a, options.MinDifficulty) || !ParseDifficulty(b, options.MaxDifficulty))
+                return Usage(), 1;
+        }
+        else if (arg == "--symmetry")
+        {
+            if (!ParseSymmetry(value, options.symmetry))
+                return Usage(), 1;
+        }
+        else
+            return Usage(), 1;
+    }
+
+    if (options.BoxN < 1 || options.BoxN > 8 || options.count < 1 || options.MinClues > options.MaxClues)
+        return Usage(), 1;
+
+    int Cells = options.BoxN * options.BoxN * options.BoxN * options.BoxN;
+    if (!ClueRange)
+        options.MinClues = 0, options.MaxClues = Cells;
+
+    // gives up on bands that are (almost) never hit.
+    options.MaxCandidates = 1000 * options.count;
+
+    FILE* out = path ? std::fopen(path, "w") : stdout;
+    if (!out)
+    {
+        std::perror(path);
+        return 1;
+    }
+
+    BatchGenerator generator(options);
+    long long produced = generator.Run([out, solutions](const GeneratedPuzzle& p)
+    {
+        std::string line = PuzzleIO::ToLine(p.puzzle);
+        if (solutions)
+            line += ' ' + PuzzleIO::ToLine(p.solution);
+
+        line += '\n';
+        std::fwrite(line.data(), 1, line.size(), out);
+    });
+
+    if (path)
+        std::fclose(out);
+
+    std::fprintf(stderr, "%lld puzzles from %lld candidates\n", produced, generator.NumberOfCandidates);
+
+    return produced == options.count ? 0 : 1;
+}
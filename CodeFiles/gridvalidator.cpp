@@ -0,0 +1,206 @@
+#include "GridValidator.h"
+#include "PuzzleIO.h"
+#include <algorithm>
+#include <cstring>
+
+typedef uint8_t Bytes __attribute__((vector_size(16)));
+typedef size_t (*Kernel)(const uint8_t* grids, const uint8_t* puzzles, size_t count, uint8_t* valid);
+
+// everything the kernel calls is inlined into it, so it is compiled for the target of the kernel.
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+KERNEL_INLINE bool Any(const Bytes& v)
+{
+    uint64_t half[2];
+    std::memcpy(half, &v, sizeof(half));
+    return (half[0] | half[1]) != 0;
+}
+
+// the lanes i + k of v in the lanes i (the last lanes repeat, they are never used).
+KERNEL_INLINE void Shift(const Bytes& v, int k, Bytes& out)
+{
+    static const Bytes by[8] =
+    {
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15 },
+        { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15, 15 },
+        { 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15, 15, 15 },
+        { 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15, 15, 15, 15 },
+        { 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15, 15, 15, 15, 15 },
+        { 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15, 15, 15, 15, 15, 15 },
+        { 7, 8, 9, 10, 11, 12, 13, 14, 15, 15, 15, 15, 15, 15, 15, 15 },
+    };
+
+    out = __builtin_shuffle(v, by[k]);
+}
+
+// a row is one vector with its nine cells in the lanes 0..8.
+// the numbers 1..8 are bits 0..7 of a byte, so a unit is right if the bits of its cells add up
+// to all eight and every cell is in 1..9: eight of the cells are then 1..8 once, and the last one
+// is a 9 or a second copy. exactly one 9 per column rules out the copies, as then every row,
+// column and box has one 9 and no room for a second copy of anything.
+KERNEL_INLINE bool Check(const uint8_t* grid, const uint8_t* puzzle)
+{
+    const Bytes zero = { 0 };
+    const Bytes one = zero + 1, eight = zero + 8, nine = zero + 9, full = zero + 255;
+    const Bytes bits = { 0, 1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0 };
+    const Bytes used = { 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 0, 0, 0, 0 };
+    const Bytes first = { 255, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    const Bytes boxes = { 255, 0, 0, 255, 0, 0, 255, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    Bytes wrong = zero, columns = zero, band = zero, nines = zero, units = full;
+
+    for (int r = 0; r < 9; r++)
+    {
+        Bytes row, a, b;
+
+        // the rows are read 16 bytes at a time, the last one ends with the grid and is moved down.
+        if (r < 8)
+            std::memcpy(&row, grid + 9 * r, sizeof(row));
+        else
+        {
+            std::memcpy(&row, grid + 65, sizeof(row));
+            Shift(row, 7, row);
+        }
+
+        wrong |= (Bytes)(row - one > eight) & used;
+        nines += (Bytes)(row == nine) & one & used;
+
+        Bytes set = __builtin_shuffle(bits, row) & used;
+        columns |= set;
+        band |= set;
+
+        // the bits of the row end up in lane 0.
+        Shift(set, 1, a);
+        Shift(set, 2, b);
+        Bytes three = set | a | b;
+        Shift(three, 3, a);
+        Shift(three, 6, b);
+        units &= (three | a | b) | ~first;
+
+        // and the bits of the boxes of a band in the lanes 0, 3 and 6.
+        if (r % 3 == 2)
+        {
+            Shift(band, 1, a);
+            Shift(band, 2, b);
+            units &= (band | a | b) | ~boxes;
+            band = zero;
+        }
+    }
+
+    wrong |= (Bytes)(columns != full) & used;
+    wrong |= (Bytes)(nines != one) & used;
+    wrong |= (Bytes)(units != full);
+
+    if (puzzle)
+    {
+        // five vectors and one more that ends with the grid.
+        for (int i = 0; i < 96; i += 16)
+        {
+            Bytes g, p;
+            int offset = std::min(i, 65);
+            std::memcpy(&g, grid + offset, sizeof(g));
+            std::memcpy(&p, puzzle + offset, sizeof(p));
+            wrong |= (Bytes)(p != zero) & (Bytes)(p != g);
+        }
+    }
+
+    return !Any(wrong);
+}
+
+KERNEL_INLINE size_t CheckAll(const uint8_t* grids, const uint8_t* puzzles, size_t count, uint8_t* valid)
+{
+    size_t res = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t offset = i * GridValidator::GridBytes;
+        bool ok = Check(grids + offset, puzzles ? puzzles + offset : nullptr);
+
+        if (valid)
+            valid[i] = ok;
+        res += ok;
+    }
+
+    return res;
+}
+
+static size_t CheckGeneric(const uint8_t* grids, const uint8_t* puzzles, size_t count, uint8_t* valid)
+{
+    return CheckAll(grids, puzzles, count, valid);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static size_t CheckAvx2(const uint8_t* grids, const uint8_t* puzzles, size_t count, uint8_t* valid)
+{
+    return CheckAll(grids, puzzles, count, valid);
+}
+
+#endif
+
+static Kernel ChooseKernel()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return CheckAvx2;
+#endif
+
+    return CheckGeneric;
+}
+
+size_t GridValidator::Validate(const uint8_t* grids, const uint8_t* puzzles, size_t count, uint8_t* valid)
+{
+    static const Kernel kernel = ChooseKernel();
+    return kernel(grids, puzzles, count, valid);
+}
+
+bool GridValidator::Validate(const Grid& grid, const Grid& puzzle)
+{
+    int BoxN = PuzzleIO::BoxSize(grid.size());
+    int N = BoxN * BoxN;
+
+    if (!BoxN || N > 64 || (!puzzle.empty() && puzzle.size() != grid.size()))
+        return false;
+
+    // a number twice in a unit is enough, N numbers in 1..N without one fill the unit.
+    std::vector<uint64_t> rows(N, 0), columns(N, 0), boxes(N, 0);
+
+    for (int r = 0; r < N; r++)
+        for (int c = 0; c < N; c++)
+        {
+            int num = grid[r * N + c];
+            if (num < 1 || num > N || (!puzzle.empty() && puzzle[r * N + c] && puzzle[r * N + c] != num))
+                return false;
+
+            uint64_t bit = 1ULL << (num - 1);
+            uint64_t& box = boxes[r / BoxN * BoxN + c / BoxN];
+
+            if ((rows[r] | columns[c] | box) & bit)
+                return false;
+
+            rows[r] |= bit;
+            columns[c] |= bit;
+            box |= bit;
+        }
+
+    return true;
+}
+
+bool GridValidator::ToBytes(const Grid& grid, uint8_t* out)
+{
+    if (grid.size() != GridBytes)
+        return false;
+
+    for (size_t i = 0; i < GridBytes; i++)
+    {
+        if (grid[i] < 0 || grid[i] > 9)
+            return false;
+
+        out[i] = (uint8_t)grid[i];
+    }
+
+    return true;
+}
@@ -0,0 +1,186 @@
+#include "LaneSolver.h"
+
+typedef LaneSolver::Vector Vector;
+
+// everything the kernel calls is inlined into it, so it is compiled for the target of the kernel.
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+static const int Lanes = LaneSolver::Lanes;
+
+// the cells of the 9 rows, 9 columns and 9 boxes.
+static int Units[27][9];
+
+static struct UnitTables
+{
+    UnitTables()
+    {
+        for (int i = 0; i < 9; i++)
+            for (int k = 0; k < 9; k++)
+            {
+                Units[i][k] = i * 9 + k;
+                Units[9 + i][k] = k * 9 + i;
+                Units[18 + i][k] = (i / 3 * 3 + k / 3) * 9 + i % 3 * 3 + k % 3;
+            }
+    }
+} tables;
+
+KERNEL_INLINE bool Any(const Vector& v)
+{
+    for (int i = 0; i < Lanes; i++)
+        if (v[i])
+            return true;
+
+    return false;
+}
+
+// all ones in the lanes where m has at most one bit.
+KERNEL_INLINE void Single(const Vector& m, Vector& out)
+{
+    const Vector zero = { 0 };
+    out = (Vector)((m & (m - 1)) == zero);
+}
+
+// one pass over the 27 units per round: every cell loses the numbers placed in its unit,
+// and a number that only one cell of the unit can take is placed there.
+// a lane fails when a unit has a number twice or can't take one, or a cell has no candidate left.
+KERNEL_INLINE uint32_t Propagate(Vector* cells)
+{
+    const Vector zero = { 0 };
+    const Vector all = zero + 511;
+    Vector failed = zero, changed;
+
+    do
+    {
+        changed = zero;
+
+        for (int u = 0; u < 27; u++)
+        {
+            const int* unit = Units[u];
+            Vector once = zero, twice = zero, placed = zero, clash = zero, single;
+
+            for (int k = 0; k < 9; k++)
+            {
+                Vector m = cells[unit[k]];
+                Single(m, single);
+
+                clash |= placed & m & single;
+                placed |= m & single;
+                twice |= once & m;
+                once |= m;
+            }
+
+            Vector hidden = once & ~twice & ~placed;
+            failed |= (Vector)(clash != zero) | (Vector)(once != all);
+
+            for (int k = 0; k < 9; k++)
+            {
+                Vector m = cells[unit[k]], h, multiple;
+                Single(m, single);
+
+                Vector n = m & (single | ~placed);
+                h = n & hidden;
+
+                // two numbers that can only go in this cell are a contradiction too.
+                Single(h, multiple);
+                Vector take = (Vector)(h != zero);
+                n = (h & take) | (n & ~take);
+
+                failed |= ~multiple | (Vector)(n == zero);
+                changed |= (Vector)(n != m);
+                cells[unit[k]] = n;
+            }
+        }
+
+        changed &= ~failed;
+    }
+    while (Any(changed));
+
+    Vector open = zero, single;
+    for (int cell = 0; cell < 81; cell++)
+    {
+        Single(cells[cell], single);
+        open |= ~single;
+    }
+
+    Vector solved = ~(failed | open);
+    uint32_t res = 0;
+
+    for (int i = 0; i < Lanes; i++)
+        if (solved[i])
+            res |= 1u << i;
+
+    return res;
+}
+
+static uint32_t PropagateGeneric(Vector* cells)
+{
+    return Propagate(cells);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static uint32_t PropagateAvx2(Vector* cells)
+{
+    return Propagate(cells);
+}
+
+#endif
+
+LaneSolver::LaneSolver()
+    : memory(81 * sizeof(Vector) + 32), loaded(0), kernel(PropagateGeneric)
+{
+    cells = (Vector*)(((uintptr_t)memory.data() + 31) & ~(uintptr_t)31);
+    Clear();
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernel = PropagateAvx2;
+#endif
+}
+
+void LaneSolver::Clear()
+{
+    // an empty lane has no candidates, so it fails right away.
+    for (int cell = 0; cell < 81; cell++)
+        cells[cell] = Vector{ 0 };
+
+    loaded = 0;
+}
+
+bool LaneSolver::Load(int lane, const Grid& puzzle)
+{
+    if (lane < 0 || lane >= Lanes)
+        return false;
+
+    bool valid = puzzle.size() == 81;
+    for (int cell = 0; valid && cell < 81; cell++)
+        valid &= puzzle[cell] >= 0 && puzzle[cell] <= 9;
+
+    for (int cell = 0; cell < 81; cell++)
+        cells[cell][lane] = !valid ? 0 : puzzle[cell] ? 1 << (puzzle[cell] - 1) : 511;
+
+    if (valid)
+        loaded |= 1u << lane;
+    else
+        loaded &= ~(1u << lane);
+
+    return valid;
+}
+
+uint32_t LaneSolver::Propagate()
+{
+    return loaded ? kernel(cells) & loaded : 0;
+}
+
+void LaneSolver::GetSolution(int lane, Grid& solution) const
+{
+    solution.resize(81);
+
+    for (int cell = 0; cell < 81; cell++)
+    {
+        int m = cells[cell][lane];
+        solution[cell] = m && !(m & (m - 1)) ? __builtin_ctz(m) + 1 : 0;
+    }
+}
@@ -1,7 +1,13 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <memory>
 #include <QTimer>
+#include <QDir>
+#include <QStandardPaths>
+#include "PuzzlePool.h"
 
 static int Time;
 static bool ShowUnlock;
@@ -10,6 +16,14 @@ static SudokuSolver solver(3);
 static Index idx;
 static bool enabled[9][9];
 static QTimer* timer;
+static PuzzlePool* pool;
+
+// the pool had no puzzle of the clue count yet, a new board is made once it has one.
+static bool generating;
+
+// the background solve started by on_Solve_clicked.
+static std::thread* solving;
+static std::atomic<bool> cancel;
 
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -24,6 +38,20 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(timer, &QTimer::timeout, this, QOverload<>::of(&MainWindow::Clock));
     timer->start(1000);
 
+    // puzzles left in the pool are kept for the next run.
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dir);
+    pool = new PuzzlePool(16, (dir + "/pool.txt").toStdString());
+    pool->SetReady([this](const PoolKey&)
+    {
+        QMetaObject::invokeMethod(this, [this]
+        {
+            if (generating)
+                on_NewBoard_clicked();
+        }, Qt::QueuedConnection);
+    });
+    pool->Want({ 3, ui->KeepCount->value() });
+
     on_NewBoard_clicked();
 }
 
@@ -61,6 +89,14 @@ void MainWindow::Refresh()
 
 MainWindow::~MainWindow()
 {
+    if (solving)
+    {
+        cancel = true;
+        solving->join();
+        delete solving;
+    }
+
+    delete pool;
     delete ui;
 }
 
@@ -115,7 +151,26 @@ void MainWindow::ResetTime()
 void MainWindow::on_NewBoard_clicked()
 {
     solver.Clear();
-    solver.SetRandomCells(ui->KeepCount->value());
+
+    // the pool is empty only for a new clue count (or right after the first start),
+    // then its worker generates one and calls back (see the constructor), the window never waits.
+    Grid puzzle;
+    PoolKey key = { 3, ui->KeepCount->value() };
+    generating = !pool->Take(key, puzzle);
+
+    if (generating)
+    {
+        DisableAll();
+        on_pause_clicked();
+        RefreshAll();
+        ui->solveTime->clear();
+        ui->message->setStyleSheet("QLabel{color: black;}");
+        ui->message->setText("Generating...");
+        ResetTime();
+        return;
+    }
+
+    solver.LoadBoard(ToBoard(puzzle, 9));
 
     for (int i = 0; i < 9; i++)
         for (int j = 0; j < 9; j++)
@@ -134,19 +189,77 @@ void MainWindow::on_NewBoard_clicked()
 
 void MainWindow::on_Solve_clicked()
 {
+    if (solving)
+        return;
+
     timer->stop();
 
     if (solver.Solved())
     {
         ui->message->setStyleSheet("QLabel{color: red;}");
         ui->message->setText("Already Solved...");
+        return;
     }
-    else if (solver.Solve())
+
+    // the search runs on a copy of the board, so the window stays responsive,
+    // and the result replaces the board in one step when it's done.
+    std::shared_ptr<SudokuSolver> task = std::make_shared<SudokuSolver>(solver);
+    cancel = false;
+    task->cancel = &cancel;
+
+    auto start = std::chrono::steady_clock::now(), posted = start;
+    task->progress = [this, start, posted](long long calls, int depth) mutable
+    {
+        // at most ten updates a second.
+        auto now = std::chrono::steady_clock::now();
+        if (now - posted < std::chrono::milliseconds(100))
+            return;
+        posted = now;
+
+        double seconds = std::chrono::duration<double>(now - start).count();
+        QMetaObject::invokeMethod(this, [this, calls, depth, seconds]
+        {
+            ui->progress->setText(QString("%1 nodes, depth %2\n%3 seconds").arg(calls).arg(depth).arg(seconds, 0, 'f', 1));
+        }, Qt::QueuedConnection);
+    };
+
+    ui->message->clear();
+    ui->solveTime->clear();
+    ui->progress->setText("Solving...");
+    SetSolving(true);
+
+    solving = new std::thread([this, task]
     {
+        bool solved = task->Solve();
+
+        QMetaObject::invokeMethod(this, [this, task, solved] { FinishSolve(*task, solved); }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::FinishSolve(const SudokuSolver& result, bool solved)
+{
+    solving->join();
+    delete solving;
+    solving = nullptr;
+
+    SetSolving(false);
+    ui->progress->clear();
+
+    if (solved)
+    {
+        solver.board = result.board;
+        solver.SolvingDuration = result.SolvingDuration;
+
         RefreshAll();
-        ui->message->clear();
         ui->solveTime->setText("Solved in " + QString::number(solver.GetDuration().count(), 'f', 5) + " seconds.");
     }
+    else if (result.Cancelled)
+    {
+        // the board was never touched, the game goes on.
+        ui->message->setStyleSheet("QLabel{color: red;}");
+        ui->message->setText("Cancelled...");
+        timer->start(1000);
+    }
     else
     {
         ui->message->setStyleSheet("QLabel{color: red;}");
@@ -154,6 +267,27 @@ void MainWindow::on_Solve_clicked()
     }
 }
 
+void MainWindow::on_cancel_clicked()
+{
+    cancel = true;
+    ui->progress->setText("Cancelling...");
+}
+
+void MainWindow::SetSolving(bool solving)
+{
+    ui->Solve->setEnabled(!solving);
+    ui->NewBoard->setEnabled(!solving);
+    ui->Reset->setEnabled(!solving);
+    ui->pause->setEnabled(!solving);
+    ui->cont->setEnabled(!solving);
+    ui->unlock->setEnabled(!solving);
+    ui->cancel->setEnabled(solving);
+
+    for (int i = 0; i < 9; i++)
+        for (int j = 0; j < 9; j++)
+            buttons[i][j]->setEnabled(!solving && enabled[i][j]);
+}
+
 void MainWindow::on_Reset_clicked()
 {
     ResetTime();
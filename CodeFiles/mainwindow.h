@@ -28,6 +28,10 @@ public:
     void UpdateTime();
 
     void ResetTime();
+
+    // disables everything that could change the board while it's solved in the background.
+    void SetSolving(bool solving);
+    void FinishSolve(const SudokuSolver& result, bool solved);
 private slots:
 
     void Clock();
@@ -117,6 +121,8 @@ private slots:
 
     void on_Solve_clicked();
 
+    void on_cancel_clicked();
+
     void on_Reset_clicked();
 
     void on_pause_clicked();
@@ -0,0 +1,80 @@
+#include "MappedFile.h"
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    if (path == "-")
+    {
+        buffer.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    size = st.st_size;
+
+    // mmap fails on empty files.
+    if (size)
+    {
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            mapping = nullptr;
+            size = 0;
+            close(fd);
+            return false;
+        }
+
+        // every byte is read once, from start to end (chunks are taken in order).
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = (const char*)mapping;
+    }
+
+    // the mapping stays valid after the file is closed.
+    close(fd);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mapping)
+        munmap(mapping, size);
+
+    mapping = nullptr;
+    data = nullptr;
+    size = 0;
+    buffer.clear();
+}
+
+size_t MappedFile::ChunkEnd(size_t begin, size_t ChunkSize) const
+{
+    size_t end = std::min(size, begin + ChunkSize);
+
+    if (end < size)
+    {
+        const void* newline = std::memchr(data + end, '\n', size - end);
+        end = newline ? (const char*)newline - data + 1 : size;
+    }
+
+    return end;
+}
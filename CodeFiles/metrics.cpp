@@ -0,0 +1,180 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const char* CounterNames[] = { "solved", "unsolvable", "invalid", "timeout" };
+
+uint64_t LatencyHistogram::UpperBound(int bucket)
+{
+    if (bucket < SubBuckets)
+        return bucket + 1;
+
+    int shift = bucket / SubBuckets - 1;
+    return ((uint64_t)(SubBuckets + bucket % SubBuckets) << shift) + ((uint64_t)1 << shift);
+}
+
+void LatencyHistogram::Clear()
+{
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+
+    count.store(0, std::memory_order_relaxed);
+    nanoseconds.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+    for (int i = 0; i < Size; i++)
+        Add(buckets[i], other.buckets[i].load(std::memory_order_relaxed));
+
+    Add(count, other.count.load(std::memory_order_relaxed));
+    Add(nanoseconds, other.nanoseconds.load(std::memory_order_relaxed));
+}
+
+double LatencyHistogram::Quantile(double q) const
+{
+    // the buckets are read one by one while they may change, so the rank comes from their sum.
+    uint64_t total = 0, seen = 0;
+    for (int i = 0; i < Size; i++)
+        total += buckets[i].load(std::memory_order_relaxed);
+
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * total));
+
+    for (int i = 0; i < Size; i++)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return UpperBound(i) * 1e-9;
+    }
+
+    return 0;
+}
+
+double LatencyHistogram::Mean() const
+{
+    uint64_t n = count.load(std::memory_order_relaxed);
+    return n ? nanoseconds.load(std::memory_order_relaxed) * 1e-9 / n : 0;
+}
+
+void SolveMetrics::Clear()
+{
+    latency.Clear();
+    for (auto& counter : counters)
+        counter.store(0, std::memory_order_relaxed);
+}
+
+void SolveMetrics::Merge(const SolveMetrics& other)
+{
+    latency.Merge(other.latency);
+    for (int i = 0; i < Counters; i++)
+        counters[i].store(counters[i].load(std::memory_order_relaxed) + other.counters[i].load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+}
+
+void SolveMetrics::AppendPrometheus(std::string& out, const std::string& prefix) const
+{
+    char buffer[512];
+    std::string name = prefix + "_solve_seconds";
+
+    // 1, 2.5 and 5 of every power of ten from 1 us to 10 s.
+    out += "# HELP " + name + " Time to solve a puzzle.\n# TYPE " + name + " histogram\n";
+
+    uint64_t cumulative = 0;
+    int bucket = 0;
+    for (double decade = 1e-6; decade < 20; decade *= 10)
+        for (double step : { 1.0, 2.5, 5.0 })
+        {
+            double le = decade * step;
+            if (le > 10)
+                break;
+
+            for (; bucket < LatencyHistogram::Size && LatencyHistogram::UpperBound(bucket) <= le * 1e9 + 0.5; bucket++)
+                cumulative += latency.buckets[bucket].load(std::memory_order_relaxed);
+
+            std::snprintf(buffer, sizeof(buffer), "%s_bucket{le=\"%g\"} %llu\n", name.c_str(), le, (unsigned long long)cumulative);
+            out += buffer;
+        }
+
+    for (; bucket < LatencyHistogram::Size; bucket++)
+        cumulative += latency.buckets[bucket].load(std::memory_order_relaxed);
+
+    std::snprintf(buffer, sizeof(buffer), "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.9f\n%s_count %llu\n",
+                  name.c_str(), (unsigned long long)cumulative, name.c_str(),
+                  latency.nanoseconds.load(std::memory_order_relaxed) * 1e-9, name.c_str(), (unsigned long long)cumulative);
+    out += buffer;
+
+    out += "# HELP " + name + "_quantile Quantiles of the time to solve a puzzle, within 3%.\n# TYPE " + name + "_quantile gauge\n";
+    for (double q : { 0.5, 0.9, 0.99, 0.999 })
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s_quantile{quantile=\"%g\"} %.9f\n", name.c_str(), q, latency.Quantile(q));
+        out += buffer;
+    }
+
+    name = prefix + "_puzzles_total";
+    out += "# HELP " + name + " Puzzles by result.\n# TYPE " + name + " counter\n";
+    for (int i = 0; i < CacheHits; i++)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s{status=\"%s\"} %llu\n", name.c_str(), CounterNames[i],
+                      (unsigned long long)counters[i].load(std::memory_order_relaxed));
+        out += buffer;
+    }
+
+    name = prefix + "_cache_hits_total";
+    std::snprintf(buffer, sizeof(buffer), "# HELP %s Puzzles answered from the solution cache.\n# TYPE %s counter\n%s %llu\n",
+                  name.c_str(), name.c_str(), name.c_str(), (unsigned long long)counters[CacheHits].load(std::memory_order_relaxed));
+    out += buffer;
+}
+
+MetricsExporter::MetricsExporter(const std::string& path, double interval, std::function<std::string()> source)
+    : path(path), interval(std::max(interval, 0.01)), source(source), stop(false)
+{
+    thread = std::thread(&MetricsExporter::Run, this);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stop = true;
+    }
+
+    wake.notify_all();
+    thread.join();
+
+    Write();
+}
+
+void MetricsExporter::Run()
+{
+    std::unique_lock<std::mutex> lock(m);
+
+    while (!wake.wait_for(lock, std::chrono::duration<double>(interval), [this] { return stop; }))
+    {
+        lock.unlock();
+        if (!Write())
+            std::perror(path.c_str());
+        lock.lock();
+    }
+}
+
+bool MetricsExporter::Write()
+{
+    std::string text = source();
+
+    if (path == "-")
+    {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return std::fflush(stdout) == 0;
+    }
+
+    std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "w");
+    if (!file)
+        return false;
+
+    bool res = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    res = std::fclose(file) == 0 && res;
+
+    return res && std::rename(temporary.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,219 @@
+#include "PuzzlePack.h"
+#include "PuzzleIO.h"
+#include "GridValidator.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// converts between the line format and the packed format.
+//
+// usage: SudokuPack pack input.txt output.sdkp
+//        SudokuPack unpack input.sdkp output.txt
+//        SudokuPack verify input.sdkp
+//
+// pack reads "puzzle [solution]" lines, the file has solutions if the first line has one.
+// every board must have the size of the first one, other lines are skipped and counted.
+// verify checks every solution of a 9 * 9 pack against its puzzle with GridValidator.
+
+static void Usage()
+{
+    std::fprintf(stderr, "usage: SudokuPack pack input.txt output.sdkp\n"
+                         "       SudokuPack unpack input.sdkp output.txt\n"
+                         "       SudokuPack verify input.sdkp\n");
+}
+
+static int Pack(const std::string& input, const std::string& output)
+{
+    MappedFile file;
+    if (!file.Open(input))
+    {
+        std::perror(input.c_str());
+        return 1;
+    }
+
+    PuzzlePackWriter writer;
+    const char* begin = file.Data();
+    const char* end = begin + file.Size();
+    long long packed = 0, skipped = 0;
+    int BoxN = 0;
+    bool solutions = false;
+    Grid puzzle, solution;
+
+    while (begin < end)
+    {
+        const char* newline = (const char*)std::memchr(begin, '\n', end - begin);
+        if (!newline)
+            newline = end;
+
+        const char* line = begin;
+        begin = newline + 1;
+
+        // up to two fields separated by spaces.
+        const char* field[2] = { nullptr, nullptr };
+        size_t length[2] = { 0, 0 };
+        const char* p = line;
+        for (int f = 0; f < 2; f++)
+        {
+            while (p < newline && (*p == ' ' || *p == '\t' || *p == '\r'))
+                p++;
+
+            field[f] = p;
+            while (p < newline && *p != ' ' && *p != '\t' && *p != '\r')
+                p++;
+            length[f] = p - field[f];
+        }
+
+        if (!length[0] || PuzzleIO::Comment(field[0], length[0]))
+            continue;
+
+        int PuzzleBox, SolutionBox = 0;
+        if (!PuzzleIO::FromLine(field[0], length[0], puzzle, PuzzleBox))
+        {
+            skipped++;
+            continue;
+        }
+
+        // the first board decides the size and whether there are solutions.
+        if (!BoxN)
+        {
+            BoxN = PuzzleBox;
+            solutions = length[1] == length[0];
+
+            if (!writer.Open(output, BoxN, solutions))
+            {
+                std::perror(output.c_str());
+                return 1;
+            }
+        }
+
+        if (PuzzleBox != BoxN ||
+            (solutions && (!PuzzleIO::FromLine(field[1], length[1], solution, SolutionBox) || SolutionBox != BoxN)))
+        {
+            skipped++;
+            continue;
+        }
+
+        if (!writer.Add(puzzle, solution))
+        {
+            std::perror(output.c_str());
+            return 1;
+        }
+
+        packed++;
+    }
+
+    if (!writer.Close())
+    {
+        std::perror(output.c_str());
+        return 1;
+    }
+
+    std::fprintf(stderr, "%lld boards packed, %lld lines skipped\n", packed, skipped);
+    return 0;
+}
+
+static int Unpack(const std::string& input, const std::string& output)
+{
+    PuzzlePackReader reader;
+    if (!reader.Open(input))
+    {
+        std::fprintf(stderr, "%s: not a valid pack\n", input.c_str());
+        return 1;
+    }
+
+    FILE* out = std::fopen(output.c_str(), "w");
+    if (!out)
+    {
+        std::perror(output.c_str());
+        return 1;
+    }
+
+    std::string text;
+    Grid grid;
+
+    for (uint64_t i = 0; i < reader.Count(); i++)
+    {
+        reader.Puzzle(i, grid);
+        PuzzleIO::AppendLine(text, grid);
+
+        if (reader.Solution(i, grid))
+        {
+            text += ' ';
+            PuzzleIO::AppendLine(text, grid);
+        }
+
+        text += '\n';
+
+        if (text.size() > (1 << 20))
+        {
+            std::fwrite(text.data(), 1, text.size(), out);
+            text.clear();
+        }
+    }
+
+    std::fwrite(text.data(), 1, text.size(), out);
+
+    return std::fclose(out) == 0 ? 0 : 1;
+}
+
+static int Verify(const std::string& input)
+{
+    PuzzlePackReader reader;
+    if (!reader.Open(input) || reader.BoxSize() != 3 || !reader.Solutions())
+    {
+        std::fprintf(stderr, "%s: not a valid 9 * 9 pack with solutions\n", input.c_str());
+        return 1;
+    }
+
+    // the records are unpacked a chunk at a time, two cells per byte into one per byte.
+    const size_t chunk = 1 << 16, bytes = GridValidator::GridBytes, half = PuzzlePack::BoardBytes(3);
+    std::vector<uint8_t> puzzles(chunk * bytes), solutions(chunk * bytes);
+    uint64_t valid = 0;
+    double seconds = 0;
+
+    for (uint64_t first = 0; first < reader.Count(); first += chunk)
+    {
+        size_t n = (size_t)std::min<uint64_t>(chunk, reader.Count() - first);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const uint8_t* record = reader.Record(first + i);
+
+            for (size_t c = 0; c < bytes; c++)
+            {
+                puzzles[i * bytes + c] = record[c / 2] >> (c % 2 * 4) & 15;
+                solutions[i * bytes + c] = record[half + c / 2] >> (c % 2 * 4) & 15;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        valid += GridValidator::Validate(solutions.data(), puzzles.data(), n, nullptr);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::fprintf(stderr, "%llu valid, %llu invalid, %.1f million grids/s\n", (unsigned long long)valid,
+                 (unsigned long long)(reader.Count() - valid), seconds > 0 ? reader.Count() / seconds * 1e-6 : 0.0);
+
+    return valid == reader.Count() ? 0 : 2;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 3 && std::string(argv[1]) == "verify")
+        return Verify(argv[2]);
+
+    if (argc != 4)
+        return Usage(), 1;
+
+    std::string mode = argv[1];
+
+    if (mode == "pack")
+        return Pack(argv[2], argv[3]);
+
+    if (mode == "unpack")
+        return Unpack(argv[2], argv[3]);
+
+    return Usage(), 1;
+}
@@ -0,0 +1,168 @@
+#include "PuzzleGenerator.h"
+
+PuzzleGenerator::PuzzleGenerator(int BoxN)
+    : PuzzleGenerator(BoxN, RNG::RandomSeed())
+{
+}
+
+PuzzleGenerator::PuzzleGenerator(int BoxN, uint64_t seed)
+    : solver(BoxN)
+{
+    ResizeBoard(BoxN);
+    Seed(seed);
+}
+
+void PuzzleGenerator::SetUnits(const UnitGraph& graph)
+{
+    BoxN = graph.BoxSize();
+    N = graph.Size();
+    Cells = N * N;
+    solver.SetUnits(graph);
+}
+
+void PuzzleGenerator::Seed(uint64_t seed)
+{
+    rng.Seed(seed);
+    solver.Seed(rng());
+}
+
+bool PuzzleGenerator::FillGrid(Grid& grid)
+{
+    solver.SetRandomized(true);
+
+    // a random fill takes a little less than a node per cell, but now and then one goes wrong
+    // early and searches for minutes (from 36 * 36 up). it starts over instead, the generator
+    // has moved on so the next one is different. the limit doubles every time, so a variant
+    // without a solution (a jigsaw that can't take the diagonals) still ends.
+    long long limit = 2 * Cells;
+
+    bool res;
+    do
+    {
+        solver.SetNodeLimit(limit);
+        solver.Load(Grid(Cells, 0));
+        res = solver.Solve();
+        limit *= 2;
+    }
+    while (!res && solver.Stopped());
+
+    solver.SetNodeLimit(0);
+
+    if (res)
+        grid = solver.GetSolution();
+
+    return res;
+}
+
+void PuzzleGenerator::Orbit(int cell, Symmetry symmetry, std::vector<int>& orbit) const
+{
+    int r = cell / N, c = cell % N;
+
+    orbit.clear();
+    orbit.push_back(cell);
+
+    int other = cell;
+    switch (symmetry)
+    {
+    case Symmetry::None:                                        break;
+    case Symmetry::Rotational:  other = Cells - 1 - cell;       break;
+    case Symmetry::Mirror:      other = r * N + (N - 1 - c);    break;
+    case Symmetry::Diagonal:    other = c * N + r;              break;
+    }
+
+    // cells on the axis (or the center) are their own partner.
+    if (other != cell)
+        orbit.push_back(other);
+}
+
+bool PuzzleGenerator::Unique(const Grid& puzzle, const Grid& solution, const std::vector<int>& removed)
+{
+    solver.SetRandomized(false);
+
+    if (!solver.Load(puzzle))
+        return false;
+
+    if (removed.size() != 1)
+        return solver.CountSolutions(2) == 1;
+
+    // with a single cell removed, any other solution has a different number in that cell.
+    // so it's enough to forbid the old number and check that nothing is left,
+    // which is much cheaper than counting two solutions.
+    int cell = removed[0];
+    if (!solver.Exclude({ cell / N, cell % N }, solution[cell]))
+        return true;
+
+    return solver.CountSolutions(1) == 0;
+}
+
+int PuzzleGenerator::RemoveClues(const Grid& solution, Grid& puzzle, int clues, Symmetry symmetry, bool minimal)
+{
+    puzzle = solution;
+    int left = Cells;
+
+    std::vector<int> order(Cells);
+    for (int i = 0; i < Cells; i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<int> orbit;
+    for (int cell : order)
+    {
+        if (!minimal && left <= clues)
+            break;
+
+        // already removed with its partner.
+        if (!puzzle[cell])
+            continue;
+
+        Orbit(cell, symmetry, orbit);
+        if (!minimal && left - (int)orbit.size() < clues)
+            continue;
+
+        for (int i : orbit)
+            puzzle[i] = 0;
+
+        if (Unique(puzzle, solution, orbit))
+            left -= orbit.size();
+        else
+            for (int i : orbit)
+                puzzle[i] = solution[i];
+    }
+
+    return left;
+}
+
+bool PuzzleGenerator::Unique(const Grid& puzzle)
+{
+    solver.SetRandomized(false);
+    return solver.Load(puzzle) && solver.Unique();
+}
+
+Difficulty PuzzleGenerator::Grade(const Grid& puzzle)
+{
+    solver.SetRandomized(false);
+
+    // only the naked singles of Load, a search without hidden singles takes forever from 36 * 36 up.
+    solver.Load(puzzle);
+    if (solver.Settled())
+        return Difficulty::Easy;
+
+    // the whole tree is searched (limit 2) so the count doesn't depend on where the solution is.
+    solver.CountSolutions(2);
+
+    if (solver.NumberOfNodes == 1)
+        return Difficulty::Medium;
+
+    if (solver.NumberOfNodes <= 2 * N)
+        return Difficulty::Hard;
+
+    return Difficulty::Expert;
+}
+
+int PuzzleGenerator::Generate(Grid& puzzle, Grid& solution, int clues, Symmetry symmetry, bool minimal)
+{
+    if (!FillGrid(solution))
+        return 0;
+
+    return RemoveClues(solution, puzzle, clues, symmetry, minimal);
+}
@@ -0,0 +1,91 @@
+#include "PuzzleIO.h"
+
+static const char Symbols[] = ".123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz@#$";
+
+// Number() of every character, built once.
+struct SymbolTable
+{
+    signed char number[256];
+
+    SymbolTable()
+    {
+        for (int i = 0; i < 256; i++)
+            number[i] = -1;
+
+        for (int i = 0; Symbols[i]; i++)
+            number[(unsigned char)Symbols[i]] = i;
+
+        number[(unsigned char)'0'] = 0;
+    }
+};
+
+static const SymbolTable table;
+
+char PuzzleIO::Symbol(int num)
+{
+    return Symbols[num];
+}
+
+int PuzzleIO::Number(char c)
+{
+    return table.number[(unsigned char)c];
+}
+
+int PuzzleIO::BoxSize(size_t length)
+{
+    for (int BoxN = 1; BoxN <= 8; BoxN++)
+        if ((size_t)BoxN * BoxN * BoxN * BoxN == length)
+            return BoxN;
+
+    return 0;
+}
+
+bool PuzzleIO::Comment(const char* field, size_t length)
+{
+    return length && field[0] == '#' && BoxSize(length) != 8;
+}
+
+std::string PuzzleIO::ToLine(const Grid& grid)
+{
+    std::string line(grid.size(), '.');
+
+    for (size_t i = 0; i < grid.size(); i++)
+        line[i] = Symbol(grid[i]);
+
+    return line;
+}
+
+void PuzzleIO::AppendLine(std::string& out, const Grid& grid)
+{
+    size_t size = out.size();
+    out.resize(size + grid.size());
+
+    for (size_t i = 0; i < grid.size(); i++)
+        out[size + i] = Symbol(grid[i]);
+}
+
+bool PuzzleIO::FromLine(const char* line, size_t length, Grid& grid, int& BoxN)
+{
+    BoxN = BoxSize(length);
+    if (!BoxN)
+        return false;
+
+    int N = BoxN * BoxN;
+    grid.resize(length);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        int num = Number(line[i]);
+        if (num < 0 || num > N)
+            return false;
+
+        grid[i] = num;
+    }
+
+    return true;
+}
+
+bool PuzzleIO::FromLine(const std::string& line, Grid& grid, int& BoxN)
+{
+    return FromLine(line.data(), line.size(), grid, BoxN);
+}
@@ -0,0 +1,208 @@
+#include "PuzzlePack.h"
+#include <cstring>
+
+static const char Magic[4] = { 'S', 'D', 'K', 'P' };
+static const uint16_t Version = 1;
+
+static void Put(uint8_t* p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t Get(const uint8_t* p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+int PuzzlePack::CellBits(int BoxN)
+{
+    int N = BoxN * BoxN, bits = 1;
+    while ((1 << bits) <= N)
+        bits++;
+    return bits;
+}
+
+size_t PuzzlePack::BoardBytes(int BoxN)
+{
+    return ((size_t)BoxN * BoxN * BoxN * BoxN * CellBits(BoxN) + 7) / 8;
+}
+
+void PuzzlePack::Pack(const Grid& grid, int bits, uint8_t* out)
+{
+    // two cells per byte, the common case.
+    if (bits == 4)
+    {
+        size_t i = 0;
+        for (; i + 1 < grid.size(); i += 2)
+            *out++ = (uint8_t)(grid[i] | grid[i + 1] << 4);
+        if (i < grid.size())
+            *out = (uint8_t)grid[i];
+        return;
+    }
+
+    uint64_t acc = 0;
+    int used = 0;
+
+    for (int v : grid)
+    {
+        acc |= (uint64_t)v << used;
+        used += bits;
+
+        while (used >= 8)
+        {
+            *out++ = (uint8_t)acc;
+            acc >>= 8;
+            used -= 8;
+        }
+    }
+
+    if (used)
+        *out = (uint8_t)acc;
+}
+
+void PuzzlePack::Unpack(const uint8_t* in, int bits, int cells, Grid& grid)
+{
+    grid.resize(cells);
+
+    if (bits == 4)
+    {
+        int i = 0;
+        for (; i + 1 < cells; i += 2, in++)
+        {
+            grid[i] = *in & 15;
+            grid[i + 1] = *in >> 4;
+        }
+        if (i < cells)
+            grid[i] = *in & 15;
+        return;
+    }
+
+    uint64_t acc = 0, mask = (1ULL << bits) - 1;
+    int have = 0;
+
+    for (int i = 0; i < cells; i++)
+    {
+        while (have < bits)
+        {
+            acc |= (uint64_t)*in++ << have;
+            have += 8;
+        }
+
+        grid[i] = (int)(acc & mask);
+        acc >>= bits;
+        have -= bits;
+    }
+}
+
+bool PuzzlePack::IsPacked(const char* data, size_t size)
+{
+    if (size < HeaderSize || std::memcmp(data, Magic, 4))
+        return false;
+
+    const uint8_t* h = (const uint8_t*)data;
+    int BoxN = h[6];
+
+    if (Get(h + 4, 2) != Version || BoxN < 1 || BoxN > 8 || h[7] != CellBits(BoxN))
+        return false;
+
+    size_t record = BoardBytes(BoxN) * (Get(h + 8, 4) & HasSolutions ? 2 : 1);
+    return (size - HeaderSize) / record >= Get(h + 12, 8);
+}
+
+bool PuzzlePackWriter::WriteHeader()
+{
+    uint8_t h[PuzzlePack::HeaderSize] = { 0 };
+
+    std::memcpy(h, Magic, 4);
+    Put(h + 4, Version, 2);
+    h[6] = (uint8_t)BoxN;
+    h[7] = (uint8_t)bits;
+    Put(h + 8, flags, 4);
+    Put(h + 12, count, 8);
+
+    return std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(h, 1, sizeof(h), file) == sizeof(h);
+}
+
+bool PuzzlePackWriter::Open(const std::string& path, int BoxN, bool solutions)
+{
+    Close();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    this->BoxN = BoxN;
+    bits = PuzzlePack::CellBits(BoxN);
+    flags = solutions ? PuzzlePack::HasSolutions : 0;
+    count = 0;
+    record.assign(PuzzlePack::BoardBytes(BoxN) * (solutions ? 2 : 1), 0);
+
+    // the count is written again on Close.
+    return WriteHeader();
+}
+
+bool PuzzlePackWriter::Add(const Grid& puzzle, const Grid& solution)
+{
+    size_t cells = (size_t)BoxN * BoxN * BoxN * BoxN;
+    if (!file || puzzle.size() != cells || ((flags & PuzzlePack::HasSolutions) && solution.size() != cells))
+        return false;
+
+    std::fill(record.begin(), record.end(), 0);
+    PuzzlePack::Pack(puzzle, bits, record.data());
+    if (flags & PuzzlePack::HasSolutions)
+        PuzzlePack::Pack(solution, bits, record.data() + record.size() / 2);
+
+    count++;
+    return std::fwrite(record.data(), 1, record.size(), file) == record.size();
+}
+
+bool PuzzlePackWriter::Close()
+{
+    if (!file)
+        return true;
+
+    bool res = WriteHeader();
+    res &= std::fclose(file) == 0;
+    file = nullptr;
+
+    return res;
+}
+
+bool PuzzlePackReader::Open(const std::string& path)
+{
+    return file.Open(path) && Attach(file.Data(), file.Size());
+}
+
+bool PuzzlePackReader::Attach(const char* data, size_t size)
+{
+    if (!PuzzlePack::IsPacked(data, size))
+        return false;
+
+    const uint8_t* h = (const uint8_t*)data;
+    BoxN = h[6];
+    bits = h[7];
+    flags = (uint32_t)Get(h + 8, 4);
+    count = Get(h + 12, 8);
+    RecordBytes = PuzzlePack::BoardBytes(BoxN) * (Solutions() ? 2 : 1);
+    records = h + PuzzlePack::HeaderSize;
+
+    return true;
+}
+
+void PuzzlePackReader::Puzzle(uint64_t i, Grid& grid) const
+{
+    PuzzlePack::Unpack(Record(i), bits, BoxN * BoxN * BoxN * BoxN, grid);
+}
+
+bool PuzzlePackReader::Solution(uint64_t i, Grid& grid) const
+{
+    if (!Solutions())
+        return false;
+
+    PuzzlePack::Unpack(Record(i) + RecordBytes / 2, bits, BoxN * BoxN * BoxN * BoxN, grid);
+    return true;
+}
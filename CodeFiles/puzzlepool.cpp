@@ -0,0 +1,179 @@
+#include "PuzzlePool.h"
+#include "PuzzleIO.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+PuzzlePool::PuzzlePool(size_t PerKey, const std::string& path, size_t MaxKeys)
+    : PerKey(PerKey), MaxKeys(std::max<size_t>(1, MaxKeys)), path(path), quit(false)
+{
+    if (!path.empty())
+        Load();
+
+    worker = std::thread(&PuzzlePool::Work, this);
+}
+
+PuzzlePool::~PuzzlePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        quit = true;
+        WorkChanged.notify_all();
+    }
+
+    worker.join();
+
+    if (!path.empty())
+        Save();
+}
+
+bool PuzzlePool::Missing(PoolKey& key) const
+{
+    for (const PoolKey& k : wanted)
+    {
+        if (puzzles.at(k).size() < PerKey)
+        {
+            key = k;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PuzzlePool::Touch(const PoolKey& key)
+{
+    auto it = std::find_if(wanted.begin(), wanted.end(), [&key](const PoolKey& k) { return !(k < key) && !(key < k); });
+
+    if (it != wanted.end())
+        wanted.erase(it);
+
+    // an empty list is enough, the worker fills it.
+    wanted.push_front(key);
+    puzzles[key];
+
+    if (wanted.size() > MaxKeys)
+    {
+        puzzles.erase(wanted.back());
+        wanted.pop_back();
+    }
+
+    WorkChanged.notify_all();
+}
+
+void PuzzlePool::SetReady(std::function<void(const PoolKey&)> ready)
+{
+    std::lock_guard<std::mutex> lock(m);
+    this->ready = ready;
+}
+
+void PuzzlePool::Want(const PoolKey& key)
+{
+    std::lock_guard<std::mutex> lock(m);
+    Touch(key);
+}
+
+bool PuzzlePool::Take(const PoolKey& key, Grid& puzzle)
+{
+    std::lock_guard<std::mutex> lock(m);
+
+    Touch(key);
+    auto& list = puzzles[key];
+
+    if (list.empty())
+        return false;
+
+    puzzle = std::move(list.front());
+    list.pop_front();
+
+    return true;
+}
+
+void PuzzlePool::Work()
+{
+    PuzzleGenerator generator(3);
+    PoolKey key;
+    Grid puzzle, solution;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            WorkChanged.wait(lock, [this, &key] { return quit || Missing(key); });
+
+            if (quit)
+                return;
+        }
+
+        // generated without holding the lock, so Take never waits for the generator.
+        generator.ResizeBoard(key.BoxN);
+        generator.Generate(puzzle, solution, key.clues);
+
+        std::function<void(const PoolKey&)> ready;
+        {
+            std::lock_guard<std::mutex> lock(m);
+
+            // the key may have been dropped while it was generated.
+            auto it = puzzles.find(key);
+            if (it == puzzles.end())
+                continue;
+
+            it->second.push_back(puzzle);
+            ready = this->ready;
+        }
+
+        // outside the lock, so ready may Take right away.
+        if (ready)
+            ready(key);
+    }
+}
+
+// one puzzle per line: BoxN, clues, then the puzzle in the line format.
+bool PuzzlePool::Load()
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m);
+
+    std::string line, text;
+    while (std::getline(in, line))
+    {
+        std::istringstream s(line);
+        PoolKey key;
+        Grid puzzle;
+        int BoxN;
+
+        if (!(s >> key.BoxN >> key.clues >> text) || !PuzzleIO::FromLine(text, puzzle, BoxN) || BoxN != key.BoxN)
+            continue;
+
+        // the file has the most recently wanted keys first, the ones past MaxKeys are dropped.
+        if (!puzzles.count(key))
+        {
+            if (wanted.size() >= MaxKeys)
+                continue;
+
+            wanted.push_back(key);
+        }
+
+        puzzles[key].push_back(puzzle);
+    }
+
+    return true;
+}
+
+bool PuzzlePool::Save()
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m);
+
+    for (const PoolKey& key : wanted)
+        for (auto& puzzle : puzzles[key])
+            out << key.BoxN << ' ' << key.clues << ' ' << PuzzleIO::ToLine(puzzle) << '\n';
+
+    return (bool)out;
+}
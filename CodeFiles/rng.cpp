@@ -1,6 +1,46 @@
 #include "RNG.h"
+#include <random>
 
-QRandomGenerator rng;
+void Xoshiro256::Seed(uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        s[i] = z ^ (z >> 31);
+    }
+}
+
+// the generator of the thread, and the one in use (itself unless a Scope is active).
+static thread_local Xoshiro256 local(RNG::RandomSeed());
+static thread_local Xoshiro256* current = nullptr;
+
+RNG::Scope::Scope(Xoshiro256& rng) : previous(current)
+{
+    current = &rng;
+}
+
+RNG::Scope::~Scope()
+{
+    current = previous;
+}
+
+Xoshiro256& RNG::Current()
+{
+    return current ? *current : local;
+}
+
+void RNG::Seed(uint64_t seed)
+{
+    Current().Seed(seed);
+}
+
+uint64_t RNG::RandomSeed()
+{
+    std::random_device dev;
+    return (uint64_t)dev() << 32 | dev();
+}
 
 int RNG::GetRandomNumber(int min, int max)
 {
@@ -8,19 +48,10 @@ int RNG::GetRandomNumber(int min, int max)
     return 0;
 #endif
 
-    return rng.bounded(min, max);
-
-    //std::random_device dev;
-    //std::mt19937 rng(dev());
-
-    //// distribution in range [min, max]
-    //std::uniform_int_distribution<std::mt19937::result_type> rand(min, max);
-
-    //return rand(rng);
+    return min + (int)Current().Bounded((uint32_t)(max - min));
 }
 
 int RNG::GetRandomNumber(int max)
 {
-    return rng.bounded(max);
-    //return GetRandomNumber(0, max);
+    return (int)Current().Bounded((uint32_t)max);
 }
@@ -0,0 +1,115 @@
+#include "SolverServer.h"
+#include "SolutionCache.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <memory>
+
+// local solving server, see SolverProtocol.h for the protocol and SudokuClient for a client.
+//
+// usage: SudokuServer [--socket path] [--engine sudoku|mask|bitboard] [--threads t] [--batch n]
+//                     [--queue n] [--clients n] [--cache entries] [--lanes on|off]
+//                     [--time-limit ms] [--metrics file] [--metrics-interval s]
+//   --socket   default /tmp/sudoku.sock.
+//   --batch    requests solved together at most (default 256).
+//   --queue    requests waiting at most (default 4096).
+//   --clients  connections at most (default 256).
+//   --lanes    propagates easy puzzles in SIMD lanes first (default off).
+//   --time-limit      stops a SudokuSolver search after ms milliseconds, it is answered as a timeout.
+//   --metrics         writes the latencies, counts and totals in the Prometheus text format
+//                     every --metrics-interval seconds (default 10), "-" for the standard output.
+// runs until SIGINT or SIGTERM, then answers the requests it has and exits.
+
+static std::atomic<bool> stop(false);
+
+static void Stop(int)
+{
+    stop = true;
+}
+
+static void Usage()
+{
+    std::fprintf(stderr, "usage: SudokuServer [--socket path] [--engine sudoku|mask|bitboard] [--threads t] [--batch n]\n"
+                         "                    [--queue n] [--clients n] [--cache entries] [--lanes on|off]\n"
+                         "                    [--time-limit ms] [--metrics file] [--metrics-interval s]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    ServerOptions options;
+    long long CacheSize = 0;
+    std::string MetricsFile;
+    double MetricsInterval = 10;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        std::string value = argv[++i];
+
+        if (arg == "--socket")
+            options.path = value;
+        else if (arg == "--threads")
+            options.threads = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--batch")
+            options.MaxBatch = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--queue")
+            options.QueueSize = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--clients")
+            options.MaxClients = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--cache")
+            CacheSize = std::atoll(value.c_str());
+        else if (arg == "--lanes" && (value == "on" || value == "off"))
+            options.lanes = value == "on";
+        else if (arg == "--time-limit")
+            options.TimeLimit = std::atof(value.c_str()) / 1000;
+        else if (arg == "--metrics")
+            MetricsFile = value;
+        else if (arg == "--metrics-interval")
+            MetricsInterval = std::atof(value.c_str());
+        else if (arg == "--engine" && ParseEngine(value, options.engine))
+            continue;
+        else
+            return Usage(), 1;
+    }
+
+    std::unique_ptr<SolutionCache> cache;
+    if (CacheSize > 0)
+        cache.reset(new SolutionCache(CacheSize));
+    options.cache = cache.get();
+
+    std::signal(SIGINT, Stop);
+    std::signal(SIGTERM, Stop);
+
+    SolverServer server(options);
+
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!MetricsFile.empty())
+        exporter.reset(new MetricsExporter(MetricsFile, MetricsInterval, [&server]
+        {
+            std::string text;
+            server.AppendPrometheus(text, "sudoku");
+            return text;
+        }));
+
+    std::fprintf(stderr, "listening on %s\n", options.path.c_str());
+    if (!server.Run(stop))
+    {
+        std::perror(options.path.c_str());
+        return 1;
+    }
+
+    exporter.reset();
+
+    long long batches = server.batches;
+    std::fprintf(stderr, "%lld connections, %lld requests in %lld batches (%.1f per batch)\n",
+                 (long long)server.connections, (long long)server.requests, batches,
+                 batches ? (double)server.requests / batches : 0.0);
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "SolutionCache.h"
+#include "PuzzlePack.h"
+#include <cstdio>
+#include <cstring>
+
+SolutionCache::SolutionCache(size_t capacity)
+    : shards(new Shard[ShardCount]), PerShard(std::max<size_t>(1, (capacity + ShardCount - 1) / ShardCount)),
+      hits(0), misses(0), inserts(0), evictions(0)
+{
+}
+
+bool SolutionCache::Lookup(const Grid& puzzle, Grid& solution, CanonicalForm& form)
+{
+    static thread_local Canonicalizer canonicalizer;
+
+    if (!canonicalizer.Canonicalize(puzzle, form))
+    {
+        form.grid.clear();
+        misses++;
+        return false;
+    }
+
+    Packed key, packed;
+    PuzzlePack::Pack(form.grid, 4, key.data());
+
+    Shard& shard = GetShard(form.hash);
+    {
+        std::lock_guard<std::mutex> lock(shard.m);
+
+        auto it = shard.map.find(form.hash);
+        if (it == shard.map.end() || it->second->puzzle != key)
+        {
+            misses++;
+            return false;
+        }
+
+        // moves the entry to the front without copying it.
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        packed = it->second->solution;
+    }
+
+    hits++;
+
+    Grid canonical;
+    PuzzlePack::Unpack(packed.data(), 4, 81, canonical);
+    form.transform.ApplyInverse(canonical, solution);
+
+    return true;
+}
+
+bool SolutionCache::Lookup(const Grid& puzzle, Grid& solution)
+{
+    CanonicalForm form;
+    return Lookup(puzzle, solution, form);
+}
+
+void SolutionCache::Insert(const CanonicalForm& form, const Grid& solution)
+{
+    if (form.grid.size() != 81 || solution.size() != 81)
+        return;
+
+    Grid canonical;
+    form.transform.Apply(solution, canonical);
+
+    Packed puzzle, packed;
+    PuzzlePack::Pack(form.grid, 4, puzzle.data());
+    PuzzlePack::Pack(canonical, 4, packed.data());
+
+    Put(form.hash, puzzle, packed);
+}
+
+void SolutionCache::Insert(const Grid& puzzle, const Grid& solution)
+{
+    static thread_local Canonicalizer canonicalizer;
+
+    CanonicalForm form;
+    if (canonicalizer.Canonicalize(puzzle, form))
+        Insert(form, solution);
+}
+
+void SolutionCache::Put(uint64_t hash, const Packed& puzzle, const Packed& solution)
+{
+    Shard& shard = GetShard(hash);
+    std::lock_guard<std::mutex> lock(shard.m);
+
+    auto it = shard.map.find(hash);
+    if (it != shard.map.end())
+    {
+        // same hash, either the same puzzle again or a collision, the newer one wins.
+        it->second->puzzle = puzzle;
+        it->second->solution = solution;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    shard.lru.push_front({ hash, puzzle, solution });
+    shard.map[hash] = shard.lru.begin();
+    inserts++;
+
+    if (shard.lru.size() > PerShard)
+    {
+        shard.map.erase(shard.lru.back().hash);
+        shard.lru.pop_back();
+        evictions++;
+    }
+}
+
+size_t SolutionCache::Size()
+{
+    size_t size = 0;
+
+    for (int i = 0; i < ShardCount; i++)
+    {
+        std::lock_guard<std::mutex> lock(shards[i].m);
+        size += shards[i].lru.size();
+    }
+
+    return size;
+}
+
+size_t SolutionCache::MemoryUsage()
+{
+    // a list node holds two pointers and the entry, a map node the next pointer,
+    // the key and the iterator, and every bucket is a pointer.
+    size_t bytes = sizeof(*this) + ShardCount * sizeof(Shard);
+
+    for (int i = 0; i < ShardCount; i++)
+    {
+        std::lock_guard<std::mutex> lock(shards[i].m);
+        bytes += shards[i].lru.size() * (sizeof(Entry) + 2 * sizeof(void*));
+        bytes += shards[i].map.size() * (sizeof(void*) + sizeof(uint64_t) + sizeof(std::list<Entry>::iterator));
+        bytes += shards[i].map.bucket_count() * sizeof(void*);
+    }
+
+    return bytes;
+}
+
+double SolutionCache::HitRate() const
+{
+    long long total = hits + misses;
+    return total ? (double)hits / total : 0;
+}
+
+bool SolutionCache::Save(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    std::vector<Entry> entries;
+    for (int i = 0; i < ShardCount; i++)
+    {
+        std::lock_guard<std::mutex> lock(shards[i].m);
+        entries.insert(entries.end(), shards[i].lru.rbegin(), shards[i].lru.rend());
+    }
+
+    uint64_t count = entries.size();
+    bool res = std::fwrite("SDKC", 1, 4, file) == 4 && std::fwrite(&count, sizeof(count), 1, file) == 1;
+
+    for (size_t i = 0; res && i < entries.size(); i++)
+        res = std::fwrite(&entries[i].hash, sizeof(uint64_t), 1, file) == 1 &&
+              std::fwrite(entries[i].puzzle.data(), 1, 41, file) == 41 &&
+              std::fwrite(entries[i].solution.data(), 1, 41, file) == 41;
+
+    res &= std::fclose(file) == 0;
+    return res;
+}
+
+bool SolutionCache::Load(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    char magic[4];
+    uint64_t count;
+    bool res = std::fread(magic, 1, 4, file) == 4 && !std::memcmp(magic, "SDKC", 4) &&
+               std::fread(&count, sizeof(count), 1, file) == 1;
+
+    Entry e;
+    for (uint64_t i = 0; res && i < count; i++)
+    {
+        res = std::fread(&e.hash, sizeof(uint64_t), 1, file) == 1 &&
+              std::fread(e.puzzle.data(), 1, 41, file) == 41 &&
+              std::fread(e.solution.data(), 1, 41, file) == 41;
+
+        if (res)
+            Put(e.hash, e.puzzle, e.solution);
+    }
+
+    std::fclose(file);
+
+    // loading isn't counted as inserting.
+    inserts = 0;
+    evictions = 0;
+
+    return res;
+}
@@ -0,0 +1,169 @@
+#include "SolverProtocol.h"
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static void Put(char* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (char)(v >> (8 * i));
+}
+
+static uint32_t Get(const char* p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)(uint8_t)p[i] << (8 * i);
+    return v;
+}
+
+void SolverProtocol::AppendFrame(std::string& out, uint32_t id, uint8_t code, const char* body, size_t length)
+{
+    char header[HeaderSize];
+
+    Put(header, (uint32_t)(length + 5));
+    Put(header + 4, id);
+    header[8] = (char)code;
+
+    out.append(header, HeaderSize);
+    out.append(body, length);
+}
+
+bool SolverProtocol::WriteAll(int fd, const char* data, size_t size)
+{
+    while (size)
+    {
+        // MSG_NOSIGNAL: a closed peer is an error here, not a SIGPIPE.
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        data += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+static bool Address(const std::string& path, sockaddr_un& addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int SolverProtocol::Listen(const std::string& path, int backlog)
+{
+    sockaddr_un addr;
+    if (!Address(path, addr))
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    // a socket file left by a server that didn't exit cleanly: nothing accepts on it.
+    // a live server, or anything that isn't a socket, is left alone and bind fails.
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        int probe = Connect(path);
+        if (probe >= 0)
+        {
+            close(probe);
+            close(fd);
+            errno = EADDRINUSE;
+            return -1;
+        }
+
+        if (errno == ECONNREFUSED)
+            unlink(path.c_str());
+    }
+
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, backlog) < 0)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+
+    return fd;
+}
+
+int SolverProtocol::Connect(const std::string& path)
+{
+    sockaddr_un addr;
+    if (!Address(path, addr))
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+
+    return fd;
+}
+
+bool FrameReader::Next(uint32_t& id, uint8_t& code, const char*& body, size_t& length)
+{
+    size_t need = SolverProtocol::HeaderSize;
+
+    while (true)
+    {
+        if (end - begin >= SolverProtocol::HeaderSize)
+        {
+            uint32_t size = Get(&buffer[begin]);
+            if (size < 5 || size - 5 > SolverProtocol::MaxBody)
+                return false;
+
+            need = 4 + size;
+            if (end - begin >= need)
+                break;
+        }
+
+        // moves the partial frame to the front to make room.
+        if (buffer.size() - begin < need)
+        {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+
+        ssize_t n = read(fd, buffer.data() + end, buffer.size() - end);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        end += n;
+    }
+
+    id = Get(&buffer[begin + 4]);
+    code = (uint8_t)buffer[begin + 8];
+    body = &buffer[begin + SolverProtocol::HeaderSize];
+    length = need - SolverProtocol::HeaderSize;
+    begin += need;
+
+    return true;
+}
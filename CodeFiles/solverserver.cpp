@@ -0,0 +1,317 @@
+#include "SolverServer.h"
+#include "SolverProtocol.h"
+#include "PuzzleIO.h"
+#include <chrono>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+SolverServer::Connection::~Connection()
+{
+    close(fd);
+}
+
+bool SolverServer::Connection::Flush()
+{
+    std::lock_guard<std::mutex> lock(write);
+
+    size_t sent = 0;
+    while (!broken && sent < pending.size())
+    {
+        // MSG_NOSIGNAL: a closed peer is an error here, not a SIGPIPE.
+        ssize_t n = send(fd, pending.data() + sent, pending.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        if (n <= 0)
+            Drop();
+        else
+            sent += n;
+    }
+
+    pending.erase(0, std::min(sent, pending.size()));
+    return pending.empty();
+}
+
+void SolverServer::Connection::Drop()
+{
+    broken = true;
+    shutdown(fd, SHUT_RDWR);
+
+    std::string().swap(pending);
+}
+
+SolverServer::SolverServer(const ServerOptions& options)
+    : options(options), solver(options.threads, options.engine), queue(std::max(1, options.QueueSize)),
+      requests(0), batches(0), connections(0)
+{
+    wake[0] = wake[1] = -1;
+
+    solver.SetCache(options.cache);
+    solver.SetLanes(options.lanes);
+    solver.SetTimeLimit(options.TimeLimit);
+}
+
+void SolverServer::AppendPrometheus(std::string& out, const std::string& prefix) const
+{
+    SolveMetrics metrics;
+    solver.Metrics(metrics);
+    metrics.AppendPrometheus(out, prefix);
+
+    const std::pair<const char*, const std::atomic<long long>*> totals[] =
+    {
+        { "requests", &requests }, { "batches", &batches }, { "connections", &connections }
+    };
+
+    for (const auto& total : totals)
+    {
+        std::string name = prefix + "_" + total.first + "_total";
+        out += "# TYPE " + name + " counter\n" + name + " " + std::to_string(total.second->load()) + "\n";
+    }
+}
+
+void SolverServer::Read(std::shared_ptr<Connection> connection)
+{
+    FrameReader reader(connection->fd);
+    uint32_t id;
+    uint8_t code;
+    const char* body;
+    size_t length;
+    int BoxN;
+
+    while (!connection->broken && reader.Next(id, code, body, length))
+    {
+        Job job;
+        job.connection = connection;
+        job.id = id;
+
+        if (code != SolverProtocol::Request || !PuzzleIO::FromLine(body, length, job.puzzle, BoxN))
+        {
+            job.puzzle.clear();
+            job.line.assign(body, length);
+        }
+
+        // blocks while the queue is full.
+        if (!queue.push(std::move(job)))
+            break;
+
+        requests++;
+    }
+}
+
+void SolverServer::Dispatch()
+{
+    std::vector<Job> jobs;
+    std::vector<SolveResult> results;
+    std::vector<Grid> puzzles;
+
+    // the responses of one batch, by connection, in the order of the requests.
+    std::unordered_map<Connection*, std::string> out;
+    std::string line;
+
+    while (queue.pop(jobs, options.MaxBatch))
+    {
+        size_t n = jobs.size();
+
+        puzzles.resize(n);
+        for (size_t i = 0; i < n; i++)
+            puzzles[i].swap(jobs[i].puzzle);
+
+        results.resize(n);
+        solver.SolveBatch(puzzles.data(), n, results.data());
+        batches++;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            SolveStatus status = results[i].status;
+
+            if (status == SolveStatus::Invalid && puzzles[i].empty())
+                line.swap(jobs[i].line);
+            else
+            {
+                line.clear();
+                PuzzleIO::AppendLine(line, status == SolveStatus::Invalid ? puzzles[i] : results[i].solution);
+            }
+
+            SolverProtocol::AppendFrame(out[jobs[i].connection.get()], jobs[i].id, (uint8_t)status, line.data(), line.size());
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            std::shared_ptr<Connection>& connection = jobs[i].connection;
+
+            auto it = out.find(connection.get());
+            if (it == out.end())
+                continue;
+
+            {
+                // a client that doesn't read its responses is dropped, its reader stops too.
+                std::lock_guard<std::mutex> lock(connection->write);
+                if (!connection->broken)
+                {
+                    connection->pending += it->second;
+                    if (connection->pending.size() > options.MaxPending)
+                        connection->Drop();
+                }
+            }
+
+            out.erase(it);
+
+            // most clients take their responses right away, the rest wait for the poll loop.
+            if (!connection->Flush())
+            {
+                std::lock_guard<std::mutex> lock(OutboxLock);
+                outbox.push_back(connection);
+
+                // a full pipe already wakes the loop up.
+                ssize_t woken = write(wake[1], "", 1);
+                (void)woken;
+            }
+        }
+
+        // the last job of a connection closes it.
+        jobs.clear();
+    }
+}
+
+bool SolverServer::Poll(int listener, int timeout)
+{
+    {
+        std::lock_guard<std::mutex> lock(OutboxLock);
+        for (auto& connection : outbox)
+            sending[connection.get()] = std::move(connection);
+        outbox.clear();
+    }
+
+    // poll skips the listener when it's -1.
+    std::vector<pollfd> fds;
+    fds.push_back({ wake[0], POLLIN, 0 });
+    fds.push_back({ listener, POLLIN, 0 });
+    for (const auto& it : sending)
+        fds.push_back({ it.second->fd, POLLOUT, 0 });
+
+    if (poll(fds.data(), fds.size(), timeout) <= 0)
+        return false;
+
+    char drain[64];
+    if (fds[0].revents)
+        while (read(wake[0], drain, sizeof(drain)) > 0)
+            ;
+
+    // a connection that has sent everything is let go, which closes it after its last request.
+    size_t i = 2;
+    for (auto it = sending.begin(); it != sending.end(); i++)
+        if (fds[i].revents && it->second->Flush())
+            it = sending.erase(it);
+        else
+            ++it;
+
+    return fds[1].revents != 0;
+}
+
+void SolverServer::Reap()
+{
+    for (auto it = clients.begin(); it != clients.end();)
+        if (*it->done)
+        {
+            it->reader.join();
+            it = clients.erase(it);
+        }
+        else
+            ++it;
+}
+
+bool SolverServer::Run(const std::atomic<bool>& stop)
+{
+    int listener = SolverProtocol::Listen(options.path);
+    if (listener < 0)
+        return false;
+
+    // the socket file as bound, so a newer server's isn't removed at the end.
+    struct stat bound;
+    bool owned = stat(options.path.c_str(), &bound) == 0;
+
+    if (pipe(wake) < 0)
+    {
+        int error = errno;
+        close(listener);
+        errno = error;
+        return false;
+    }
+
+    fcntl(wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake[1], F_SETFL, O_NONBLOCK);
+
+    std::thread dispatcher(&SolverServer::Dispatch, this);
+
+    while (!stop)
+    {
+        Reap();
+
+        // wakes up now and then to look at stop.
+        if (!Poll(listener, 200))
+            continue;
+
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        if ((int)clients.size() >= options.MaxClients)
+        {
+            close(fd);
+            continue;
+        }
+
+        connections++;
+
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>(fd);
+
+        Client client;
+        client.connection = connection;
+        client.done = std::make_shared<std::atomic<bool>>(false);
+        client.reader = std::thread([this](std::shared_ptr<Connection> connection, std::shared_ptr<std::atomic<bool>> done)
+        {
+            Read(std::move(connection));
+            *done = true;
+        }, std::move(connection), client.done);
+
+        clients.push_back(std::move(client));
+    }
+
+    close(listener);
+
+    struct stat now;
+    if (owned && lstat(options.path.c_str(), &now) == 0 && now.st_dev == bound.st_dev && now.st_ino == bound.st_ino)
+        unlink(options.path.c_str());
+
+    // no new requests, the queued ones are still answered.
+    for (auto& client : clients)
+        if (auto connection = client.connection.lock())
+            shutdown(connection->fd, SHUT_RD);
+
+    for (auto& client : clients)
+        client.reader.join();
+    clients.clear();
+
+    queue.close();
+    dispatcher.join();
+
+    // the last responses, for a few seconds at most.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((!sending.empty() || !outbox.empty()) && std::chrono::steady_clock::now() < deadline)
+        Poll(-1, 200);
+
+    sending.clear();
+    outbox.clear();
+
+    close(wake[0]);
+    close(wake[1]);
+    wake[0] = wake[1] = -1;
+
+    return true;
+}
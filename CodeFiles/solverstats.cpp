@@ -0,0 +1,92 @@
+#include "SolverStats.h"
+#include <algorithm>
+#include <cstdio>
+
+static const char* StrategyNames[] = { "naked_singles", "hidden_singles", "pointing_claiming" };
+static const char* PhaseNames[] = { "load", "propagate", "search" };
+
+void SolverStats::Clear()
+{
+    solves = solved = nodes = assignments = backtracks = 0;
+    MaxDepth = 0;
+
+    std::fill(propagations, propagations + Strategies, 0);
+    std::fill(seconds, seconds + Phases, 0.0);
+    std::fill(CandidatesAtBranch, CandidatesAtBranch + Buckets, 0);
+    std::fill(&BranchingFactor[0][0], &BranchingFactor[0][0] + Depths * Buckets, 0);
+}
+
+void SolverStats::Add(const SolverStats& other)
+{
+    solves += other.solves;
+    solved += other.solved;
+    nodes += other.nodes;
+    assignments += other.assignments;
+    backtracks += other.backtracks;
+    MaxDepth = std::max(MaxDepth, other.MaxDepth);
+
+    for (int i = 0; i < Strategies; i++)
+        propagations[i] += other.propagations[i];
+
+    for (int i = 0; i < Phases; i++)
+        seconds[i] += other.seconds[i];
+
+    for (int i = 0; i < Buckets; i++)
+        CandidatesAtBranch[i] += other.CandidatesAtBranch[i];
+
+    // the depths below MaxDepth are the only ones that can be counted.
+    for (int d = 0; d <= std::min(other.MaxDepth, Depths - 1); d++)
+        for (int i = 0; i < Buckets; i++)
+            BranchingFactor[d][i] += other.BranchingFactor[d][i];
+}
+
+static void AppendArray(std::string& out, const long long* values, int count)
+{
+    out += '[';
+    for (int i = 0; i < count; i++)
+    {
+        if (i)
+            out += ", ";
+        out += std::to_string(values[i]);
+    }
+    out += ']';
+}
+
+void SolverStats::AppendJson(std::string& out) const
+{
+    char buffer[64];
+
+    out += "{\"solves\": " + std::to_string(solves) + ", \"solved\": " + std::to_string(solved) +
+           ", \"nodes\": " + std::to_string(nodes) + ", \"assignments\": " + std::to_string(assignments) +
+           ", \"backtracks\": " + std::to_string(backtracks) + ", \"max_depth\": " + std::to_string(MaxDepth);
+
+    out += ", \"propagations\": {";
+    for (int i = 0; i < Strategies; i++)
+        out += std::string(i ? ", " : "") + "\"" + StrategyNames[i] + "\": " + std::to_string(propagations[i]);
+
+    out += "}, \"seconds\": {";
+    for (int i = 0; i < Phases; i++)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s\"%s\": %.6f", i ? ", " : "", PhaseNames[i], seconds[i]);
+        out += buffer;
+    }
+
+    out += "}, \"candidates_at_branch\": ";
+    AppendArray(out, CandidatesAtBranch, Buckets);
+
+    out += ", \"branching_factor\": [";
+    for (int d = 0; d <= std::min(MaxDepth, Depths - 1); d++)
+    {
+        if (d)
+            out += ", ";
+        AppendArray(out, BranchingFactor[d], Buckets);
+    }
+    out += "]}";
+}
+
+std::string SolverStats::ToJson() const
+{
+    std::string out;
+    AppendJson(out);
+    return out;
+}
@@ -1,4 +1,7 @@
 #include "SudokuBoard.h"
+#include "CompactBoard.h"
+#include "Trace.h"
+#include <algorithm>
 
 SudokuBoard::SudokuBoard(const Board& board, int BoxN)
 {
@@ -8,7 +11,7 @@ SudokuBoard::SudokuBoard(const Board& board, int BoxN)
 
 int SudokuBoard::BoxNum(const Index& idx) const
 {
-    return (idx.r / BoxN * BoxN) + (idx.c / BoxN);
+    return graph.Region(idx.r * N + idx.c);
     //  -----------
     // | 0 | 1 | 2 |
     // |---+---+---|
@@ -18,23 +21,31 @@ int SudokuBoard::BoxNum(const Index& idx) const
     //  -----------
 }
 
-void SudokuBoard::UpdateAvailable(int CandidatesCount)
+const Index& SudokuBoard::GetRandomCell(int CandidatesCount) const
 {
+    const std::vector<Index>& bucket = CellsWithNCandidates[CandidatesCount];
 
-#if PRINT_DEBUG_FUNCTIONS
-    if (print)
-    std::cout << "In UpdateAvailable with CandidatesCount = " << CandidatesCount
-        << ", CellsWithNCandidates is "
-        << (CandidatesCount != -1 && CellsWithNCandidates[CandidatesCount].empty() ? "" : "not ")
-        << "empty" << std::endl;
+#if NO_RANDOMIZATION
+    return *std::min_element(bucket.begin(), bucket.end()); // to disable the random behavior.
 #endif
 
+    return bucket[RNG::GetRandomNumber(bucket.size())];
+}
+
+void SudokuBoard::UpdateAvailable(int CandidatesCount)
+{
+    // the cells without candidates aren't available, Possible looks at them.
+    if (CandidatesCount == 0)
+        return;
+
     if (CandidatesCount != -1)
     {
+        uint64_t bit = (uint64_t)1 << (CandidatesCount - 1);
+
         if (CellsWithNCandidates[CandidatesCount].empty())
-            available.erase(CandidatesCount);
+            available &= ~bit;
         else
-            available.insert(CandidatesCount);
+            available |= bit;
 
         return;
     }
@@ -43,32 +54,34 @@ void SudokuBoard::UpdateAvailable(int CandidatesCount)
         UpdateAvailable(i);
 }
 
-
 void SudokuBoard::InsertIdx(int CandidatesCount, const Index& idx)
 {
+    int& position = BucketPosition[idx.r * N + idx.c];
+    if (position != -1)
+        return;
 
-#if PRINT_DEBUG_FUNCTIONS
-
-    std::cout << "In InsertIdx with CandidatesCount = " << CandidatesCount
-        << ", idx = { " << idx.r << ", " << idx.c << " }" << std::endl;
+    std::vector<Index>& bucket = CellsWithNCandidates[CandidatesCount];
+    position = bucket.size();
+    bucket.push_back(idx);
 
-#endif
-
-    CellsWithNCandidates[CandidatesCount].insert(idx);
     UpdateAvailable(CandidatesCount);
 }
 
 void SudokuBoard::EraseIdx(int CandidatesCount, const Index& idx)
 {
+    int& position = BucketPosition[idx.r * N + idx.c];
+    std::vector<Index>& bucket = CellsWithNCandidates[CandidatesCount];
 
-#if PRINT_DEBUG_FUNCTIONS
+    if (position == -1 || position >= (int)bucket.size() || bucket[position].r != idx.r || bucket[position].c != idx.c)
+        return;
 
-    std::cout << "In EraseIdx with CandidatesCount = " << CandidatesCount
-        << ", idx = { " << idx.r << ", " << idx.c << " }" << std::endl;
+    // the last cell takes the place of idx.
+    const Index& last = bucket.back();
+    BucketPosition[last.r * N + last.c] = position;
+    bucket[position] = last;
+    bucket.pop_back();
+    position = -1;
 
-#endif
-
-    CellsWithNCandidates[CandidatesCount].erase(idx);
     UpdateAvailable(CandidatesCount);
 }
 
@@ -77,25 +90,34 @@ bool SudokuBoard::isCandidate(const Index& idx, int num)
     return Candidates.find(num) != Candidates.end();
 }
 
+// the rows are units 0..N - 1 of the graph, the columns N..2N - 1 and the boxes 2N..3N - 1.
 bool SudokuBoard::inRow(int r, int num) const
 {
-    return row[r][num];
+    return inUnit(r, num);
 }
 
 bool SudokuBoard::inColumn(int c, int num) const
 {
-    return column[c][num];
+    return inUnit(N + c, num);
 }
 
 bool SudokuBoard::inBox(int b, int num) const
 {
-    return box[b][num];
+    return inUnit(2 * N + b, num);
+}
+
+bool SudokuBoard::inUnit(int u, int num) const
+{
+    return unit[u] >> (num - 1) & 1;
 }
 
 void SudokuBoard::SetBoard(const Board& board, bool clear)
 {
     if (clear)
-        Clear();
+    {
+        Reload(board);
+        return;
+    }
 
     // TODO: needs validation for input.
     for (int i = 0; i < std::min((int)board.size(), N); i++)
@@ -107,80 +129,180 @@ void SudokuBoard::SetBoard(const Board& board, bool clear)
     //	- all cells are already empty at the begining. there is no need to empty it again.
 }
 
-void SudokuBoard::ResizeBoard(int BoxN, bool keep)
+// the heap bytes of the members, a vector counts those of its elements too.
+template <typename T> static size_t HeapBytes(const T&) { return 0; }
+template <typename T> static size_t HeapBytes(const std::vector<T>& v)
 {
-    this->BoxN = BoxN;
-    N = BoxN * BoxN;
+    size_t bytes = v.capacity() * sizeof(T);
+    for (const T& t : v)
+        bytes += HeapBytes(t);
+
+    return bytes;
+}
 
+size_t SudokuBoard::MemoryUsage() const
+{
+    return sizeof(*this) + HeapBytes(board) + graph.MemoryUsage() - sizeof(graph) + HeapBytes(unit) +
+           HeapBytes(candidates) + HeapBytes(CellsWithNCandidates) + HeapBytes(BucketPosition);
+}
+
+bool SudokuBoard::ToCompact(CompactBoard& compact) const
+{
+    if (N != CompactBoard::N || !graph.Classic())
+        return false;
+
+    compact.Clear();
+
+    for (int r = 0; r < N; r++)
+        for (int c = 0; c < N; c++)
+        {
+            int cell = r * N + c, num = board[r][c];
+
+            compact.cells[cell] = num;
+            compact.filled += num != 0;
+            compact.candidates[cell] = 0;
+            for (int candidate : candidates[r][c])
+                compact.candidates[cell] |= 1 << (candidate - 1);
+
+            if (num)
+            {
+                compact.rows[r] |= 1 << (num - 1);
+                compact.columns[c] |= 1 << (num - 1);
+                compact.boxes[BoxNum({ r, c })] |= 1 << (num - 1);
+            }
+        }
+
+    return true;
+}
+
+void SudokuBoard::SetBoard(const CompactBoard& compact)
+{
+    if (N != CompactBoard::N || !graph.Classic())
+        ResizeBoard(3);
+    else
+        Clear();
+
+    // the cells first, every number is still a candidate of an empty board.
+    for (int cell = 0; cell < CompactBoard::Cells; cell++)
+        if (compact.cells[cell])
+            SetCell({ cell / N, cell % N }, compact.cells[cell]);
+
+    // then the candidates the cells don't explain, deleted or added back by a strategy.
+    for (int cell = 0; cell < CompactBoard::Cells; cell++)
+        for (int num = 1; num <= N; num++)
+        {
+            Index idx = { cell / N, cell % N };
+
+            if (compact.isCandidate(cell, num))
+                AddCandidate(idx, num);
+            else
+                DeleteCandidate(idx, num);
+        }
+}
+
+void SudokuBoard::SetUnits(const UnitGraph& graph, bool keep)
+{
     Board board = keep ? this->board : EmptyBoard;
 
-    Clear();
+    this->graph = graph;
+    BoxN = graph.BoxSize();
+    N = graph.Size();
+
+    // the only place the board allocates, besides the buckets growing.
+    this->board.assign(N, std::vector<int>(N, 0));
+    candidates.assign(N, std::vector<NumberSet>(N));
+    unit.assign(graph.UnitCount(), 0);
+
+    // N + 1 because CellsWithCandidates[N] should be accessible.
+    CellsWithNCandidates.assign(N + 1, std::vector<Index>());
+    CellsWithNCandidates[N].reserve(N * N);
+    BucketPosition.assign(N * N, -1);
 
     // empty cells won't override.
     // only valid cells will be set.
-    SetBoard(board);
+    Reload(board);
 }
 
 void SudokuBoard::Clear()
 {
-    // board = N * N vector filled with zeroes (empty).
-    board = std::vector < std::vector<int>>(N, std::vector<int>(N, 0));
+    Reload(EmptyBoard);
+}
 
-    candidates = std::vector<std::vector<std::set<int>>>(N, std::vector<std::set<int>>(N));
-    // each cell will have all candidates from 1 to N.
-    for (int i = 0; i < N; i++)
-        for (int j = 0; j < N; j++)
-            for (int candidate = 1; candidate <= N; candidate++)
-                candidates[i][j].insert(candidate);
+bool SudokuBoard::Reload(const Board& board)
+{
+    return Load([&board](int i, int j) { return i < (int)board.size() && j < (int)board[i].size() ? board[i][j] : 0; });
+}
 
-    // N + 1 because CellsWithCandidates[N] should be accessible.
-    CellsWithNCandidates = std::vector<Container<Index>>(N + 1);
+bool SudokuBoard::Reload(const std::vector<int>& cells)
+{
+    return Load([this, &cells](int i, int j) { return i * N + j < (int)cells.size() ? cells[i * N + j] : 0; });
+}
+
+template <typename Cell> bool SudokuBoard::Load(Cell cell)
+{
+    uint64_t all = N == 64 ? ~(uint64_t)0 : ((uint64_t)1 << N) - 1;
+    bool kept = true;
+
+    std::fill(unit.begin(), unit.end(), 0);
 
-    // all cells will have N candidates at the begining.
+    // the clues in order, one that is already in a unit of its cell isn't a candidate and is skipped.
     for (int i = 0; i < N; i++)
         for (int j = 0; j < N; j++)
-            CellsWithNCandidates[N].insert({ i, j });
+        {
+            int num = cell(i, j);
+            uint64_t bit = num >= 1 && num <= N ? (uint64_t)1 << (num - 1) : 0;
 
-    // in an empty board, all cells will have N candidates.
-    available.clear();
-    available.insert(N);
+            if (bit && (Placed(i * N + j) & bit))
+                bit = 0;
 
-    // N * (N + 1) vector filled with false.
-    // N + 1 because row[N - 1][N] should be accessible.
-    row		= std::vector < std::vector<bool> >(N, std::vector<bool>(N + 1, false));
-    column	= std::vector < std::vector<bool> >(N, std::vector<bool>(N + 1, false));
-    box		= std::vector < std::vector<bool> >(N, std::vector<bool>(N + 1, false));
+            kept &= bit || !num;
 
-#if APPLY_PointingClaming
+            this->board[i][j] = bit ? num : 0;
+            for (const int* u = graph.UnitsBegin(i * N + j); u != graph.UnitsEnd(i * N + j); u++)
+                unit[*u] |= bit;
+        }
 
-    // at the begining, every cell will have every number as a candidate.
-    RowIndices		= std::vector< std::vector< std::set< Index > > >(N, std::vector<std::set<Index>>(N + 1));
-    ColumnIndices	= std::vector< std::vector< std::set< Index > > >(N, std::vector<std::set<Index>>(N + 1));
-    BoxIndices		= std::vector< std::vector< std::set< Index > > >(N, std::vector<std::set<Index>>(N + 1));
+    for (auto& bucket : CellsWithNCandidates)
+        bucket.clear();
 
+    // a cell keeps the numbers no unit of it has, set cells too (SetCell deletes its number from itself).
     for (int i = 0; i < N; i++)
         for (int j = 0; j < N; j++)
-            for (int k = 1; k <= N; k++)
-                RowIndices[i][k].insert({ i, j }),
-                ColumnIndices[i][k].insert({ j, i }),
-                BoxIndices[BoxNum({ i, j })][k].insert({ i, j });
+        {
+            uint64_t bits = all & ~Placed(i * N + j);
+            candidates[i][j].SetBits(bits);
+
+            int& position = BucketPosition[i * N + j];
+            position = -1;
+
+            if (!this->board[i][j])
+            {
+                std::vector<Index>& bucket = CellsWithNCandidates[__builtin_popcountll(bits)];
+                position = bucket.size();
+                bucket.push_back({ i, j });
+            }
+        }
+
+    available = 0;
+    UpdateAvailable();
+
+    BoardTrace::Record(TraceEvent::Reset, 0, 0, BoxN);
+    return kept;
+}
 
-#endif
+uint64_t SudokuBoard::Placed(int cell) const
+{
+    uint64_t bits = 0;
+    for (const int* u = graph.UnitsBegin(cell); u != graph.UnitsEnd(cell); u++)
+        bits |= unit[*u];
 
+    return bits;
 }
 
 // TODO: AddCandidate and DeleteCandidate are almost identical.
 
 bool SudokuBoard::AddCandidate(const Index& idx, int num, bool propagate)
 {
-
-#if PRINT_DEBUG_FUNCTIONS
-
-    std::cout << "In AddCandidate with idx = { " << idx.r << ", " << idx.c << " }, "
-        << "num = " << num << ", propagate = " << std::boolalpha << propagate << std::endl;
-
-#endif
-
 #if PRINT_DEBUG_ERRORS
 
     //if (propagate && Candidates.empty() && !board[idx.r][idx.c])
@@ -188,7 +310,7 @@ bool SudokuBoard::AddCandidate(const Index& idx, int num, bool propagate)
 
 #endif
 
-    if (inRow(idx.r, num) || inColumn(idx.c, num) || inBox(BoxNum(idx), num))
+    if (Placed(idx.r * N + idx.c) >> (num - 1) & 1)
         return false;
 
     auto it = Candidates.find(num);
@@ -201,42 +323,30 @@ bool SudokuBoard::AddCandidate(const Index& idx, int num, bool propagate)
 
     if (propagate)
     {
-        ForEachCellInRow(idx.r, &SudokuBoard::AddCandidate, num, false);
-        ForEachCellInColumn(idx.c, &SudokuBoard::AddCandidate, num, false);
-        ForEachCellInBox(BoxNum(idx), &SudokuBoard::AddCandidate, num, false);
+        int cell = idx.r * N + idx.c;
+        for (const int* it = graph.ScopeBegin(cell); it != graph.ScopeEnd(cell); it++)
+            AddCandidate({ *it / N, *it % N }, num, false);
         return true;
     }
 
-#if APPLY_PointingClaming
-
-    RowIndices[idx.r][num].insert(idx);
-    ColumnIndices[idx.c][num].insert(idx);
-    BoxIndices[BoxNum(idx)][num].insert(idx);
-
-#endif
-
     EraseIdx(Candidates.size(), idx);
 
     // it's normal to add candidates even if the cell is not empty.
     Candidates.insert(num);
+    BoardTrace::Record(TraceEvent::AddCandidate, idx.r, idx.c, num);
 
     // if the cell is not empty, don't add it as available.
     if (!board[idx.r][idx.c])
+    {
         InsertIdx(Candidates.size(), idx);
+        BoardTrace::Record(TraceEvent::MoveBucket, idx.r, idx.c, num, Candidates.size() - 1, Candidates.size());
+    }
 
     return true;
 }
 
 bool SudokuBoard::DeleteCandidate(const Index& idx, int num, bool propagate)
 {
-
-#if PRINT_DEBUG_FUNCTIONS
-
-    std::cout << "In DeleteCandidate with idx = { " << idx.r << ", " << idx.c << " }, "
-        << "num = " << num << ", propagate = " << std::boolalpha << propagate << std::endl;
-
-#endif
-
 #if PRINT_DEBUG_ERRORS
 
     if (propagate && Candidates.empty() && !board[idx.r][idx.c])
@@ -253,42 +363,30 @@ bool SudokuBoard::DeleteCandidate(const Index& idx, int num, bool propagate)
 
     if (propagate)
     {
-        ForEachCellInRow(idx.r, &SudokuBoard::DeleteCandidate, num, false);
-        ForEachCellInColumn(idx.c, &SudokuBoard::DeleteCandidate, num, false);
-        ForEachCellInBox(BoxNum(idx), &SudokuBoard::DeleteCandidate, num, false);
+        int cell = idx.r * N + idx.c;
+        for (const int* it = graph.ScopeBegin(cell); it != graph.ScopeEnd(cell); it++)
+            DeleteCandidate({ *it / N, *it % N }, num, false);
         return true;
     }
 
-#if APPLY_PointingClaming
-
-    RowIndices[idx.r][num].erase(idx);
-    ColumnIndices[idx.c][num].erase(idx);
-    BoxIndices[BoxNum(idx)][num].erase(idx);
-
-#endif
-
     EraseIdx(Candidates.size(), idx);
 
     // it's normal to erase candidates even if the cell is not empty.
     Candidates.erase(it);
+    BoardTrace::Record(TraceEvent::DeleteCandidate, idx.r, idx.c, num);
 
     // if the board is not empty, don't add it as available.
     if (!board[idx.r][idx.c])
+    {
         InsertIdx(Candidates.size(), idx);
+        BoardTrace::Record(TraceEvent::MoveBucket, idx.r, idx.c, num, Candidates.size() + 1, Candidates.size());
+    }
 
     return true;
 }
 
 bool SudokuBoard::SetCell(const Index& idx, int num)
 {
-
-#if PRINT_DEBUG_FUNCTIONS
-
-    std::cout << "In SetCell with idx = { " << idx.r << ", " << idx.c << " }, "
-        << "num = " << num << std::endl;
-
-#endif
-
     // not in the candidates.
     if (!isCandidate(idx, num))
         return false;
@@ -300,27 +398,10 @@ bool SudokuBoard::SetCell(const Index& idx, int num)
 
     board[idx.r][idx.c] = num;
 
-    row[idx.r][num] = true;
-    column[idx.c][num] = true;
-    box[BoxNum(idx)][num] = true;
-
-#if PRINT_DEBUG_BOARDS
-
-#if PRINT_DEBUG_BOARDS_INFORMATION
-    std::cout << "Set Cell { " << idx.r << ", " << idx.c << " } the number " << num << std::endl;
-#endif
-
-    std::cout << x << std::endl;
-    for (int i = 0; i < N; i++)
-    {
-        for (int j = 0; j < N; j++)
-            std::cout << board[i][j] << ' ';
-        std::cout << std::endl;
-    }
-    std::cout << std::endl << std::endl;
-
-#endif
+    for (const int* u = graph.UnitsBegin(idx.r * N + idx.c); u != graph.UnitsEnd(idx.r * N + idx.c); u++)
+        unit[*u] |= (uint64_t)1 << (num - 1);
 
+    BoardTrace::Record(TraceEvent::SetCell, idx.r, idx.c, num);
     DeleteCandidate(idx, num, true);
 
     return true;
@@ -328,13 +409,6 @@ bool SudokuBoard::SetCell(const Index& idx, int num)
 
 bool SudokuBoard::UnsetCell(const Index& idx)
 {
-
-#if PRINT_DEBUG_FUNCTIONS
-
-    std::cout << "In UnsetCell with idx = { " << idx.r << ", " << idx.c << " }" << std::endl;
-
-#endif
-
     // the cell is empty.
     // assuming that the program is correct, this can be commented.
     if (!board[idx.r][idx.c])
@@ -346,27 +420,10 @@ bool SudokuBoard::UnsetCell(const Index& idx)
     // since it won't be listed as available if it's set.
     board[idx.r][idx.c] = 0; // 0 = empty.
 
-    row[idx.r][num] = false;
-    column[idx.c][num] = false;
-    box[BoxNum(idx)][num] = false;
-
-#if PRINT_DEBUG_BOARDS
-
-#if PRINT_DEBUG_BOARDS_INFORMATION
-    std::cout << "Unset Cell { " << idx.r << ", " << idx.c << " } the number " << num << std::endl;
-#endif
-
-    std::cout << x << std::endl;
-    for (int i = 0; i < N; i++)
-    {
-        for (int j = 0; j < N; j++)
-            std::cout << board[i][j] << ' ';
-        std::cout << std::endl;
-    }
-    std::cout << std::endl << std::endl;
-
-#endif
+    for (const int* u = graph.UnitsBegin(idx.r * N + idx.c); u != graph.UnitsEnd(idx.r * N + idx.c); u++)
+        unit[*u] &= ~((uint64_t)1 << (num - 1));
 
+    BoardTrace::Record(TraceEvent::UnsetCell, idx.r, idx.c, num);
     AddCandidate(idx, num, true);
 
     return true;
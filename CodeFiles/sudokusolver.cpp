@@ -1,4 +1,5 @@
 #include "SudokuSolver.h"
+#include <set>
 
 bool SudokuSolver::Possible() const
 {
@@ -7,7 +8,15 @@ bool SudokuSolver::Possible() const
 
 bool SudokuSolver::Solved() const
 {
-    return board.available.empty();
+    return !board.available;
+}
+
+bool SudokuSolver::Return(bool solved)
+{
+    if (trace)
+        trace->Record(TraceEvent::Return, Depth, 0, 0, solved);
+
+    return solved;
 }
 
 void SudokuSolver::StartDuration()
@@ -25,10 +34,11 @@ void SudokuSolver::EndDuration()
 
 Index SudokuSolver::GetNextCell()
 {
-    if (board.available.empty()) return { -1, };
+    if (!board.available) return { -1, -1 };
 
-    int MinimumCandidates = *(board.available.begin());
-    return board.CellsWithNCandidates[MinimumCandidates].GetRandom();
+    // the lowest bit is the fewest candidates.
+    int MinimumCandidates = __builtin_ctzll(board.available) + 1;
+    return board.GetRandomCell(MinimumCandidates);
 }
 
 void SudokuSolver::Clear()
@@ -38,18 +48,48 @@ void SudokuSolver::Clear()
 
 void SudokuSolver::LoadBoard(const Board& board)
 {
+    TimePoint start = std::chrono::steady_clock::now();
     this->board.SetBoard(board, true);
+    LoadSeconds = SudokuSolverDuration(std::chrono::steady_clock::now() - start).count();
+}
+
+bool SudokuSolver::LoadGrid(const Grid& grid)
+{
+    TimePoint start = std::chrono::steady_clock::now();
+    bool kept = board.Reload(grid);
+    LoadSeconds = SudokuSolverDuration(std::chrono::steady_clock::now() - start).count();
+
+    return kept;
 }
 
 bool SudokuSolver::Solve()
 {
     NumberOfCalls = 0;
     NumberOfValidCalls = 0;
+    Depth = 0;
+    Cancelled = false;
+
+    stats.Clear();
+    stats.seconds[SolverStats::Load] = LoadSeconds;
+    LoadSeconds = 0;
+
+    RNG::Scope scope(rng);
+
+    if (trace)
+        trace->Begin(board.BoxN, ToGrid(board.board, board.N), rng);
 
     StartDuration();
     bool res = Backtrack();
     EndDuration();
 
+    if (trace)
+        trace->End();
+
+    stats.solves = 1;
+    stats.solved = res;
+    stats.nodes = NumberOfCalls;
+    stats.seconds[SolverStats::Search] = std::max(0.0, SolvingDuration.count() - stats.seconds[SolverStats::Propagate]);
+
     return res;
 }
 
@@ -57,23 +97,51 @@ bool SudokuSolver::Backtrack()
 {
     ++NumberOfCalls;
 
-    if (!Possible())
-        return false;
+    if (trace)
+        trace->Record(TraceEvent::Node, Depth);
+
+    // progress comes first, so it can set the cancel flag (a time limit) and stop the search right away.
+    if (NumberOfCalls % ProgressInterval == 0)
+    {
+        if (progress)
+            progress(NumberOfCalls, Depth);
+
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            Cancelled = true;
+    }
+
+    // a cancelled search unwinds through the remaining candidates without going deeper.
+    if (Cancelled || !Possible())
+        return Return(false);
 
 #if APPLY_STRATEGIES
 
     State ChangesMade;
+    TimePoint start = std::chrono::steady_clock::now();
 
     // applies strategies until no changes had been made.
     while (ApplyStrategies(ChangesMade));
 
+    stats.seconds[SolverStats::Propagate] += SudokuSolverDuration(std::chrono::steady_clock::now() - start).count();
+
+    if (trace)
+        trace->Record(TraceEvent::Propagate, Depth, 0, 0, 0, ChangesMade.CellIndex.size() + ChangesMade.CandidateIndex.size());
+
+    // a strategy can leave a cell without candidates after the check above,
+    // GetNextCell doesn't see those cells and would take the board for solved.
+    if (!Possible())
+    {
+        UndoStrategies(ChangesMade);
+        return Return(false);
+    }
+
 #endif
 
     // index is obtained after applying the strategies.
     Index idx = GetNextCell();
 
     if (idx.r == -1)
-        return true;
+        return Return(true);
 
     ++NumberOfValidCalls;
 
@@ -81,18 +149,37 @@ bool SudokuSolver::Backtrack()
     //  - the set may change inside the loop.
     //  - to allow random access.
     LiteContainer<int> candidates(board.Candidates);
+    int children = 0, options = candidates.size();
+
+    stats.Branch(Depth, options);
+
     while (!candidates.empty())
     {
+        ++children;
+        ++stats.assignments;
+
+        int num = candidates.PopRandom();
+        if (trace)
+            trace->Record(TraceEvent::Decision, Depth, idx.r, idx.c, num, options);
 
 #if PRINT_DEBUG_ERRORS
-        if (!board.SetCell(idx, candidates.PopRandom()))
+        if (!board.SetCell(idx, num))
             std::cout << "Can't Set Cell" << std::endl;
 #else
-        board.SetCell(idx, candidates.PopRandom());
+        board.SetCell(idx, num);
 #endif
 
-        if (Backtrack())
-            return true;
+        ++Depth;
+        bool solved = Backtrack();
+        --Depth;
+
+        if (solved)
+        {
+            stats.Tried(Depth, children);
+            return Return(true);
+        }
+
+        ++stats.backtracks;
 
 #if PRINT_DEBUG_ERRORS
         if (!board.UnsetCell(idx))
@@ -101,21 +188,25 @@ bool SudokuSolver::Backtrack()
         board.UnsetCell(idx);
 #endif
 
+        if (trace)
+            trace->Record(TraceEvent::Backtrack, Depth, idx.r, idx.c, num);
     }
 
+    stats.Tried(Depth, children);
+
 #if APPLY_STRATEGIES
     UndoStrategies(ChangesMade);
 #endif
 
-    return false;
+    return Return(false);
 }
 
 bool SudokuSolver::Validate() const
 {
-    // checking that every number from 1..N exists in each row, column, box.
-    for (int i = 0; i < board.N; i++)
+    // checking that every number from 1..N exists in each unit (rows, columns, boxes and the ones of a variant).
+    for (int u = 0; u < board.graph.UnitCount(); u++)
         for (int num = 1; num <= board.N; num++)
-            if (!board.inRow(i, num) || !board.inColumn(i, num) || !board.inBox(i, num))
+            if (!board.inUnit(u, num))
                 return false;
 
     return true;
@@ -123,6 +214,8 @@ bool SudokuSolver::Validate() const
 
 bool SudokuSolver::SetRandomCells(int cells)
 {
+    RNG::Scope scope(rng);
+
     if (!Solve())
         return false;
 
@@ -140,30 +233,46 @@ bool SudokuSolver::SetRandomCells(int cells)
     return true;
 }
 
+bool SudokuSolver::SetUniqueCells(int cells, Symmetry symmetry, bool minimal)
+{
+    if (!Solve())
+        return false;
+
+    Grid solution = ToGrid(board.board, board.N), puzzle;
+
+    PuzzleGenerator generator(board.BoxN, rng());
+    generator.SetUnits(board.graph);
+    generator.RemoveClues(solution, puzzle, cells, symmetry, minimal);
+
+    LoadBoard(ToBoard(puzzle, board.N));
+
+    return true;
+}
+
 void SudokuSolver::GenerateBoards(int num, std::vector<std::vector<std::vector<int>>>& list, int shuffle)
 {
     Solve();
 
-    std::vector<int> permutation;
-    for (int i = 0; i <= board.N; i++)
-        permutation.push_back(i);
-
-    auto begin = permutation.begin();
-    begin++;
+    Grid solved = ToGrid(board.board, board.N), b;
+    std::vector<int> lines(board.N);
+    for (int i = 0; i < board.N; i++)
+        lines[i] = i;
 
-    do
+    // each board is the solved one under a random transformation of the whole group,
+    // not just a relabeling, so consecutive boards don't look alike.
+    // the units of a variant only survive the relabeling.
+    while (num-- > 0)
     {
-        if (!num) break;
-        num--;
+        SudokuTransform transform = SudokuTransform::Random(board.BoxN, rng);
+        if (!board.graph.Classic())
+            transform = SudokuTransform(board.BoxN, false, lines, lines, transform.GetNumberMap());
 
-        Board b(board.N, std::vector<int>(board.N));
-        ChangeNumbers(b, permutation);
-        list.push_back(b);
-
-    } while (std::next_permutation(begin, permutation.end()));
+        transform.Apply(solved, b);
+        list.push_back(ToBoard(b, board.N));
+    }
 
     while (shuffle--)
-        std::swap(list[RNG::GetRandomNumber((int)list.size())], list[RNG::GetRandomNumber((int)list.size())]);
+        std::swap(list[rng.Bounded((uint32_t)list.size())], list[rng.Bounded((uint32_t)list.size())]);
 }
 
 void SudokuSolver::ChangeNumbers(std::vector<std::vector<int>>& b, std::vector<int>& permutation)
@@ -215,9 +324,10 @@ bool SudokuSolver::SetNakedSingles(State& state)
     bool Changed = !board.CellsWithNCandidates[1].empty();
     while (!board.CellsWithNCandidates[1].empty())
     {
-        Index idx = board.CellsWithNCandidates[1].GetRandom();
+        Index idx = board.GetRandomCell(1);
         board.SetCell(idx, *board.Candidates.begin());
         state.CellIndex.push_back(idx);
+        ++stats.propagations[SolverStats::NakedSingles];
     }
     return Changed;
 }
@@ -227,82 +337,45 @@ bool SudokuSolver::SetNakedSingles(State& state)
 #if APPLY_PointingClaming
 bool SudokuSolver::PointingClaming(State& state)
 {
-    // if n (n < BoxN) cells are the only cells with candidate c
-    // in box b and they are in the same row/column, delete the
-    // candidate c from every other cell outside the box b in
-    // the same row/column.
-
-    // TODO: can be done in reverse
-    // if some candidate is only in some cells in the same box,
-    // delete all the instances of that candidate in that box.
+    // if the empty cells of a unit with candidate num are all in one segment
+    // of a family (the cells it shares with another unit), delete num from
+    // every other cell of that unit. on a classic board the families of a box
+    // are its rows and its columns (pointing), the family of a line its boxes (claiming).
 
     bool Changed = false;
+    const UnitGraph& graph = board.graph;
+    int N = board.N;
 
-    for (int candidate = 1; candidate <= board.N; candidate++)
+    for (const UnitGraph::Family& family : graph.Families())
     {
-        for (int box = 0; box < board.N; box++)
-        {
-            int size = board.BoxIndices[box][candidate].size();
-            if (!size || size > board.BoxN) continue;
+        const int* unit = graph.Unit(family.unit);
+        int rest = family.others.size();
 
-            int r = box / board.BoxN * board.BoxN;
-            int c = box % board.BoxN * board.BoxN;
-
-            int row = 0, col = 0;
-            for (int i = 0; i < board.BoxN; i++)
+        for (int num = 1; num <= N; num++)
+        {
+            // -1 if num isn't in an empty cell, rest if it's in more than one segment.
+            int segment = -1;
+            for (int i = 0; i < N && segment != rest; i++)
             {
-                if (board.isCandidate({ r, c + i }, candidate))
-                    row++;
+                Index idx = { unit[i] / N, unit[i] % N };
+                if (board.board[idx.r][idx.c] || !board.isCandidate(idx, num))
+                    continue;
 
-                if (board.isCandidate({ r + i, c }, candidate))
-                    col++;
+                segment = segment == -1 || segment == family.segment[i] ? family.segment[i] : rest;
             }
 
-            // TODO: row and colmun code are almost the same.
-            if (row == size && board.RowIndices[r][candidate].size() > row)
-            {
-                Changed = true;
-
-                // TODO: alot of duplicate code.
-                for (int i = 0; i < c; i++)
-                {
-                    if (board.DeleteCandidate({ r, i }, candidate))
-                    {
-                        state.CandidateIndex.push_back({ r, i });
-                        state.CandidateValue.push_back(candidate);
-                    }
-                }
-
-                for (int i = c + board.BoxN; i < board.N; i++)
-                {
-                    if (board.DeleteCandidate({ r, i }, candidate))
-                    {
-                        state.CandidateIndex.push_back({ r, i });
-                        state.CandidateValue.push_back(candidate);
-                    }
-                }
-            }
+            if (segment == -1 || segment == rest)
+                continue;
 
-            if (col == size && board.ColumnIndices[c][candidate].size() > col)
+            for (int cell : family.targets[segment])
             {
-                Changed = true;
-
-                for (int i = 0; i < r; i++)
-                {
-                    if (board.DeleteCandidate({ i, c }, candidate))
-                    {
-                        state.CandidateIndex.push_back({ i, c });
-                        state.CandidateValue.push_back(candidate);
-                    }
-                }
-
-                for (int i = r + board.BoxN; i < board.N; i++)
+                Index idx = { cell / N, cell % N };
+                if (!board.board[idx.r][idx.c] && board.DeleteCandidate(idx, num))
                 {
-                    if (board.DeleteCandidate({ i, c }, candidate))
-                    {
-                        state.CandidateIndex.push_back({ i, c });
-                        state.CandidateValue.push_back(candidate);
-                    }
+                    Changed = true;
+                    state.CandidateIndex.push_back(idx);
+                    state.CandidateValue.push_back(num);
+                    ++stats.propagations[SolverStats::PointingClaiming];
                 }
             }
         }
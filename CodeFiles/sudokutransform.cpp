@@ -0,0 +1,59 @@
+#include "SudokuTransform.h"
+
+SudokuTransform::SudokuTransform(int BoxN)
+    : N(BoxN * BoxN), BoxN(BoxN), CellMap(N * N), NumberMap(N + 1)
+{
+    for (int i = 0; i < N * N; i++)
+        CellMap[i] = i;
+
+    for (int i = 0; i <= N; i++)
+        NumberMap[i] = i;
+}
+
+SudokuTransform::SudokuTransform(int BoxN, bool transpose, const std::vector<int>& RowMap,
+                                 const std::vector<int>& ColumnMap, const std::vector<int>& NumberMap)
+    : N(BoxN * BoxN), BoxN(BoxN), CellMap(N * N), NumberMap(NumberMap)
+{
+    for (int r = 0; r < N; r++)
+        for (int c = 0; c < N; c++)
+            CellMap[r * N + c] = transpose ? RowMap[c] * N + ColumnMap[r]
+                                           : RowMap[r] * N + ColumnMap[c];
+}
+
+void SudokuTransform::Apply(const int* in, int* out) const
+{
+    const int* map = CellMap.data();
+    const int* numbers = NumberMap.data();
+
+    for (int i = 0; i < N * N; i++)
+        out[i] = numbers[in[map[i]]];
+}
+
+void SudokuTransform::Apply(const Grid& in, Grid& out) const
+{
+    out.resize(N * N);
+    Apply(in.data(), out.data());
+}
+
+void SudokuTransform::ApplyInverse(const int* in, int* out) const
+{
+    int inverse[65];
+    for (int i = 0; i <= N; i++)
+        inverse[NumberMap[i]] = i;
+
+    for (int i = 0; i < N * N; i++)
+        out[CellMap[i]] = inverse[in[i]];
+}
+
+void SudokuTransform::ApplyInverse(const Grid& in, Grid& out) const
+{
+    out.resize(N * N);
+    ApplyInverse(in.data(), out.data());
+}
+
+Board SudokuTransform::Apply(const Board& board) const
+{
+    Grid out;
+    Apply(ToGrid(board, N), out);
+    return ToBoard(out, N);
+}
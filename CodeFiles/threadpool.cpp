@@ -0,0 +1,142 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads)
+    : size(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      generation(0), running(0), quit(false)
+{
+    ranges.reset(new Range[size]);
+
+    for (int t = 1; t < size; t++)
+        this->threads.emplace_back(&ThreadPool::Loop, this, t);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        quit = true;
+        started.notify_all();
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+bool ThreadPool::Next(int worker, size_t& i)
+{
+    Range& own = ranges[worker];
+    std::lock_guard<std::mutex> lock(own.m);
+
+    if (own.begin >= own.end)
+        return false;
+
+    i = own.begin++;
+    return true;
+}
+
+bool ThreadPool::Steal(int worker)
+{
+    // the sizes are read one lock at a time, so the victim may be smaller by the time it's locked.
+    int victim = -1;
+    size_t most = 0;
+
+    for (int k = 1; k < size; k++)
+    {
+        int w = (worker + k) % size;
+        std::lock_guard<std::mutex> lock(ranges[w].m);
+
+        size_t left = ranges[w].end - std::min(ranges[w].begin, ranges[w].end);
+        if (left > most)
+        {
+            most = left;
+            victim = w;
+        }
+    }
+
+    if (victim < 0)
+        return false;
+
+    size_t begin, end;
+    {
+        std::lock_guard<std::mutex> lock(ranges[victim].m);
+        Range& r = ranges[victim];
+
+        if (r.begin >= r.end)
+            return true;						// someone was faster, look again.
+
+        end = r.end;
+        begin = r.begin + (r.end - r.begin) / 2;
+        r.end = begin;
+    }
+
+    std::lock_guard<std::mutex> lock(ranges[worker].m);
+    ranges[worker].begin = begin;
+    ranges[worker].end = end;
+
+    return true;
+}
+
+void ThreadPool::Work(int worker)
+{
+    size_t i;
+
+    do
+    {
+        while (Next(worker, i))
+            job(worker, i);
+    }
+    while (Steal(worker));
+}
+
+void ThreadPool::Loop(int worker)
+{
+    long long seen = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            started.wait(lock, [&] { return quit || generation != seen; });
+
+            if (quit)
+                return;
+
+            seen = generation;
+        }
+
+        Work(worker);
+
+        std::lock_guard<std::mutex> lock(m);
+        if (--running == 0)
+            finished.notify_all();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, std::function<void(int, size_t)> f)
+{
+    if (!count)
+        return;
+
+    job = std::move(f);
+
+    // even ranges, the first ones get the remainder.
+    for (int w = 0; w < size; w++)
+    {
+        std::lock_guard<std::mutex> lock(ranges[w].m);
+        ranges[w].begin = count / size * w + std::min<size_t>(w, count % size);
+        ranges[w].end = ranges[w].begin + count / size + (w < (int)(count % size));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        running = size - 1;
+        generation++;
+        started.notify_all();
+    }
+
+    Work(0);
+
+    std::unique_lock<std::mutex> lock(m);
+    finished.wait(lock, [&] { return running == 0; });
+}
@@ -0,0 +1,232 @@
+#include "Trace.h"
+#include <cstring>
+
+static const char Magic[4] = { 'S', 'D', 'K', 'T' };
+static const char SearchMagic[4] = { 'S', 'D', 'K', 'S' };
+static const uint16_t Version = 1;
+static const size_t SearchHeaderSize = 48;
+
+static size_t RingCapacity = 1 << 20;
+
+const char* TraceEventName(TraceEvent event)
+{
+    static const char* names[] = { "reset", "set", "unset", "delete", "add", "move",
+                                   "node", "propagate", "decision", "backtrack", "return" };
+    return (size_t)event < sizeof(names) / sizeof(names[0]) ? names[(size_t)event] : "unknown";
+}
+
+RingTrace::Ring& RingTrace::Local()
+{
+    static thread_local Ring ring;
+
+    if (ring.records.empty())
+        ring.records.resize(RingCapacity);
+
+    return ring;
+}
+
+void RingTrace::SetCapacity(size_t capacity)
+{
+    // a power of two, so the position is a mask of the count.
+    RingCapacity = 1;
+    while (RingCapacity < capacity)
+        RingCapacity *= 2;
+}
+
+uint64_t RingTrace::Count()
+{
+    return Local().count;
+}
+
+void RingTrace::Copy(std::vector<TraceRecord>& out)
+{
+    Ring& ring = Local();
+    uint64_t size = ring.records.size();
+    uint64_t first = ring.count > size ? ring.count - size : 0;
+
+    out.clear();
+    for (uint64_t i = first; i < ring.count; i++)
+        out.push_back(ring.records[i & (size - 1)]);
+}
+
+void RingTrace::Clear()
+{
+    Ring& ring = Local();
+    ring.records.assign(RingCapacity, TraceRecord());
+    ring.count = 0;
+}
+
+FileTrace::Writer::~Writer()
+{
+    if (file)
+    {
+        Flush(*this);
+        std::fclose(file);
+    }
+}
+
+FileTrace::Writer& FileTrace::Local()
+{
+    static thread_local Writer writer;
+    return writer;
+}
+
+void FileTrace::Flush(Writer& writer)
+{
+    if (writer.file && !writer.buffer.empty())
+        std::fwrite(writer.buffer.data(), sizeof(TraceRecord), writer.buffer.size(), writer.file);
+
+    writer.buffer.clear();
+}
+
+bool FileTrace::Open(const std::string& path)
+{
+    Close();
+
+    Writer& writer = Local();
+    writer.file = std::fopen(path.c_str(), "wb");
+    if (!writer.file)
+        return false;
+
+    uint8_t header[HeaderSize];
+    uint16_t size = sizeof(TraceRecord);
+    std::memcpy(header, Magic, 4);
+    std::memcpy(header + 4, &Version, 2);
+    std::memcpy(header + 6, &size, 2);
+
+    writer.buffer.reserve(4096);
+    return std::fwrite(header, 1, HeaderSize, writer.file) == HeaderSize;
+}
+
+bool FileTrace::Close()
+{
+    Writer& writer = Local();
+    if (!writer.file)
+        return true;
+
+    Flush(writer);
+    bool res = std::fclose(writer.file) == 0;
+    writer.file = nullptr;
+
+    return res;
+}
+
+bool FileTrace::Read(const std::string& path, std::vector<TraceRecord>& records)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    uint8_t header[HeaderSize];
+    uint16_t version, size;
+    bool res = std::fread(header, 1, HeaderSize, file) == HeaderSize && !std::memcmp(header, Magic, 4);
+
+    if (res)
+    {
+        std::memcpy(&version, header + 4, 2);
+        std::memcpy(&size, header + 6, 2);
+        res = version == Version && size == sizeof(TraceRecord);
+    }
+
+    records.clear();
+
+    TraceRecord chunk[4096];
+    size_t n;
+    while (res && (n = std::fread(chunk, sizeof(TraceRecord), 4096, file)) > 0)
+        records.insert(records.end(), chunk, chunk + n);
+
+    std::fclose(file);
+    return res;
+}
+
+bool SearchTrace::Begin(int BoxN, const std::vector<int>& cells, const Xoshiro256& rng)
+{
+    End();
+
+    this->BoxN = BoxN;
+    this->cells.assign(cells.begin(), cells.end());
+    rng.GetState(state);
+    records.clear();
+    start = std::chrono::steady_clock::now();
+
+    if (path.empty())
+        return true;
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    uint8_t header[SearchHeaderSize] = {};
+    uint16_t size = sizeof(SearchRecord);
+    std::memcpy(header, SearchMagic, 4);
+    std::memcpy(header + 4, &Version, 2);
+    std::memcpy(header + 6, &size, 2);
+    header[8] = (uint8_t)BoxN;
+    std::memcpy(header + 16, state, sizeof(state));
+
+    records.reserve(4096);
+    return std::fwrite(header, 1, SearchHeaderSize, file) == SearchHeaderSize &&
+           std::fwrite(this->cells.data(), 1, this->cells.size(), file) == this->cells.size();
+}
+
+void SearchTrace::Flush()
+{
+    std::fwrite(records.data(), sizeof(SearchRecord), records.size(), file);
+    records.clear();
+}
+
+bool SearchTrace::End()
+{
+    if (!file)
+        return true;
+
+    Flush();
+    bool res = std::fclose(file) == 0;
+    file = nullptr;
+
+    return res;
+}
+
+Xoshiro256 SearchTrace::Generator() const
+{
+    Xoshiro256 rng;
+    rng.SetState(state);
+    return rng;
+}
+
+bool SearchTrace::Read(const std::string& path, SearchTrace& trace)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    uint8_t header[SearchHeaderSize];
+    uint16_t version, size;
+    bool res = std::fread(header, 1, SearchHeaderSize, file) == SearchHeaderSize && !std::memcmp(header, SearchMagic, 4);
+
+    if (res)
+    {
+        std::memcpy(&version, header + 4, 2);
+        std::memcpy(&size, header + 6, 2);
+        res = version == Version && size == sizeof(SearchRecord) && header[8] >= 1 && header[8] <= 8;
+    }
+
+    trace.End();
+    trace.records.clear();
+
+    if (res)
+    {
+        trace.BoxN = header[8];
+        std::memcpy(trace.state, header + 16, sizeof(trace.state));
+        trace.cells.resize(trace.BoxN * trace.BoxN * trace.BoxN * trace.BoxN);
+        res = std::fread(trace.cells.data(), 1, trace.cells.size(), file) == trace.cells.size();
+    }
+
+    SearchRecord chunk[4096];
+    size_t n;
+    while (res && (n = std::fread(chunk, sizeof(SearchRecord), 4096, file)) > 0)
+        trace.records.insert(trace.records.end(), chunk, chunk + n);
+
+    std::fclose(file);
+    return res;
+}
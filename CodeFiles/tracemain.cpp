@@ -0,0 +1,314 @@
+#include "SudokuSolver.h"
+#include "PuzzleIO.h"
+#include "Trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// records the search of SudokuSolver on one puzzle, and looks at the recording offline.
+//
+// usage: SudokuTrace record puzzles.txt output.sdks [--line n] [--seed s]
+//        SudokuTrace report input.sdks [--top k]
+//        SudokuTrace replay input.sdks
+//
+// record solves the n-th puzzle of the file (default the first) and writes its search.
+// report rebuilds the search tree, lists the k failed subtrees with the most nodes (default 10),
+// which is the work the search threw away, and where the time went by depth.
+// replay runs the search again from the same cells and generator state, and checks that it
+// makes the same decisions.
+
+static void Usage()
+{
+    std::fprintf(stderr, "usage: SudokuTrace record puzzles.txt output.sdks [--line n] [--seed s]\n"
+                         "       SudokuTrace report input.sdks [--top k]\n"
+                         "       SudokuTrace replay input.sdks\n");
+}
+
+// a call of the search, and the decision of its parent that led to it.
+struct TreeNode
+{
+	int parent, depth;
+	int r, c, num;
+	long long nodes = 1;
+	long long propagations = 0;
+	uint64_t start, end = 0;
+	uint64_t ChildTime = 0;
+	bool solved = false;
+};
+
+static bool ReadPuzzle(const std::string& path, int line, Grid& grid, int& BoxN)
+{
+    std::ifstream in(path);
+    std::string text;
+
+    for (int n = 0; std::getline(in, text); )
+    {
+        while (!text.empty() && (text.back() == '\r' || text.back() == ' '))
+            text.pop_back();
+
+        // the puzzle is the first field, a solution may follow it.
+        std::string field = text.substr(0, text.find_first_of(" \t"));
+        if (field.empty() || PuzzleIO::Comment(field.data(), field.size()) || !PuzzleIO::FromLine(field, grid, BoxN))
+            continue;
+
+        if (++n == line)
+            return true;
+    }
+
+    return false;
+}
+
+static std::string Cell(const TreeNode& node)
+{
+    return "r" + std::to_string(node.r + 1) + "c" + std::to_string(node.c + 1) + "=" + PuzzleIO::Symbol(node.num);
+}
+
+// the nodes in the order they started, the root first. false if the records aren't a whole search.
+static bool BuildTree(const std::vector<SearchRecord>& records, std::vector<TreeNode>& tree)
+{
+    std::vector<int> stack;
+    TreeNode edge = {};
+
+    tree.clear();
+
+    for (const SearchRecord& record : records)
+    {
+        switch (record.event)
+        {
+        case TraceEvent::Node:
+            edge.parent = stack.empty() ? -1 : stack.back();
+            edge.depth = record.depth;
+            edge.start = record.time;
+            tree.push_back(edge);
+            stack.push_back(tree.size() - 1);
+            break;
+
+        case TraceEvent::Decision:
+            edge.r = record.r;
+            edge.c = record.c;
+            edge.num = record.num;
+            break;
+
+        case TraceEvent::Propagate:
+            if (stack.empty())
+                return false;
+            tree[stack.back()].propagations += record.count;
+            break;
+
+        case TraceEvent::Return:
+        {
+            if (stack.empty())
+                return false;
+
+            TreeNode& node = tree[stack.back()];
+            node.end = record.time;
+            node.solved = record.num;
+            stack.pop_back();
+
+            if (node.parent >= 0)
+            {
+                tree[node.parent].nodes += node.nodes;
+                tree[node.parent].ChildTime += node.end - node.start;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    return !tree.empty() && stack.empty();
+}
+
+static int Record(int argc, char* argv[])
+{
+    int line = 1;
+    bool seeded = false;
+    uint64_t seed = 0;
+
+    for (int i = 4; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage(), 1;
+
+        if (arg == "--line")
+            line = std::atoi(argv[++i]);
+        else if (arg == "--seed")
+            seed = std::strtoull(argv[++i], nullptr, 10), seeded = true;
+        else
+            return Usage(), 1;
+    }
+
+    Grid grid;
+    int BoxN;
+    if (!ReadPuzzle(argv[2], line, grid, BoxN))
+    {
+        std::fprintf(stderr, "%s: no puzzle %d\n", argv[2], line);
+        return 1;
+    }
+
+    SearchTrace trace;
+    trace.Open(argv[3]);
+
+    SudokuSolver solver;
+    solver.ResizeBoard(BoxN);
+    solver.LoadBoard(ToBoard(grid, BoxN * BoxN));
+    if (seeded)
+        solver.Seed(seed);
+
+    solver.trace = &trace;
+    bool solved = solver.Solve();
+    solver.trace = nullptr;
+
+    if (!trace.End())
+    {
+        std::perror(argv[3]);
+        return 1;
+    }
+
+    std::printf("%s, %d nodes, %.3f ms\n", solved ? "solved" : "no solution", solver.NumberOfCalls, solver.SolvingDuration.count() * 1e3);
+    return 0;
+}
+
+static int Report(int argc, char* argv[])
+{
+    size_t top = 10;
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (std::string(argv[i]) != "--top" || i + 1 >= argc)
+            return Usage(), 1;
+        top = std::atoi(argv[++i]);
+    }
+
+    SearchTrace trace;
+    std::vector<TreeNode> tree;
+    if (!SearchTrace::Read(argv[2], trace) || !BuildTree(trace.records, tree))
+    {
+        std::fprintf(stderr, "%s: not a whole search trace\n", argv[2]);
+        return 1;
+    }
+
+    const TreeNode& root = tree[0];
+    double total = (root.end - root.start) * 1e-6;
+    int clues = 0;
+    for (uint8_t cell : trace.cells)
+        clues += cell != 0;
+
+    std::printf("%d x %d, %d clues, %zu events, %lld nodes, %s, %.3f ms\n", trace.BoxN * trace.BoxN, trace.BoxN * trace.BoxN,
+                clues, trace.records.size(), root.nodes, root.solved ? "solved" : "no solution", total);
+
+    // the subtrees on the way to the solution hold everything below them, so only the failed ones are listed.
+    // a subtree of a listed one may be listed too.
+    std::vector<int> order;
+    for (int i = 1; i < (int)tree.size(); i++)
+        if (!tree[i].solved)
+            order.push_back(i);
+
+    top = std::min(top, order.size());
+    std::partial_sort(order.begin(), order.begin() + top, order.end(), [&tree](int a, int b)
+    {
+        return tree[a].nodes != tree[b].nodes ? tree[a].nodes > tree[b].nodes : a < b;
+    });
+
+    std::printf("\nlargest failed subtrees:\n%6s  %-10s %10s %7s %10s  %s\n", "depth", "decision", "nodes", "share", "ms", "after");
+    for (size_t i = 0; i < top; i++)
+    {
+        const TreeNode& node = tree[order[i]];
+        std::printf("%6d  %-10s %10lld %6.1f%% %10.3f  %s\n", node.depth, Cell(node).c_str(), node.nodes,
+                    100.0 * node.nodes / root.nodes, (node.end - node.start) * 1e-6, node.parent ? Cell(tree[node.parent]).c_str() : "-");
+    }
+
+    // the time of a node without its children, added up by depth.
+    struct Level { long long nodes = 0, propagations = 0, failed = 0; uint64_t time = 0; };
+    std::vector<Level> levels;
+
+    for (const TreeNode& node : tree)
+    {
+        if (node.depth >= (int)levels.size())
+            levels.resize(node.depth + 1);
+
+        Level& level = levels[node.depth];
+        level.nodes++;
+        level.propagations += node.propagations;
+        level.failed += !node.solved;
+        level.time += node.end - node.start - node.ChildTime;
+    }
+
+    std::printf("\nby depth:\n%6s %10s %10s %12s %10s %7s\n", "depth", "nodes", "failed", "propagations", "ms", "time");
+    for (int d = 0; d < (int)levels.size(); d++)
+        std::printf("%6d %10lld %10lld %12lld %10.3f %6.1f%%\n", d, levels[d].nodes, levels[d].failed, levels[d].propagations,
+                    levels[d].time * 1e-6, total > 0 ? 100.0 * levels[d].time * 1e-6 / total : 0.0);
+
+    return 0;
+}
+
+static bool SameEvent(const SearchRecord& a, const SearchRecord& b)
+{
+    return a.event == b.event && a.r == b.r && a.c == b.c && a.num == b.num && a.depth == b.depth && a.count == b.count;
+}
+
+static int Replay(const std::string& path)
+{
+    SearchTrace recorded, replayed;
+    std::vector<TreeNode> tree;
+    if (!SearchTrace::Read(path, recorded) || !BuildTree(recorded.records, tree))
+    {
+        std::fprintf(stderr, "%s: not a whole search trace\n", path.c_str());
+        return 1;
+    }
+
+    int N = recorded.BoxN * recorded.BoxN;
+    Grid grid(recorded.cells.begin(), recorded.cells.end());
+
+    SudokuSolver solver;
+    solver.ResizeBoard(recorded.BoxN);
+    solver.LoadBoard(ToBoard(grid, N));
+    solver.Seed(recorded.Generator());
+
+    solver.trace = &replayed;
+    solver.Solve();
+    solver.trace = nullptr;
+
+    const std::vector<SearchRecord>& a = recorded.records;
+    const std::vector<SearchRecord>& b = replayed.records;
+
+    size_t i = 0;
+    while (i < a.size() && i < b.size() && SameEvent(a[i], b[i]))
+        i++;
+
+    if (i < a.size() || i < b.size())
+    {
+        std::printf("diverged at event %zu of %zu\n", i, a.size());
+        for (const std::vector<SearchRecord>* records : { &a, &b })
+            if (i < records->size())
+                std::printf("  %s: %s depth %d r%dc%d num %d count %d\n", records == &a ? "recorded" : "replayed",
+                            TraceEventName((*records)[i].event), (*records)[i].depth, (*records)[i].r + 1,
+                            (*records)[i].c + 1, (*records)[i].num, (*records)[i].count);
+        return 2;
+    }
+
+    std::printf("same search, %zu events, %lld nodes, %.3f ms recorded, %.3f ms replayed\n", a.size(), tree[0].nodes,
+                (a.back().time - a.front().time) * 1e-6, (b.back().time - b.front().time) * 1e-6);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 2 ? argv[1] : "";
+
+    if (mode == "record" && argc >= 4)
+        return Record(argc, argv);
+
+    if (mode == "report")
+        return Report(argc, argv);
+
+    if (mode == "replay" && argc == 3)
+        return Replay(argv[2]);
+
+    return Usage(), 1;
+}
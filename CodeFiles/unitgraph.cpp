@@ -0,0 +1,292 @@
+#include "UnitGraph.h"
+#include <algorithm>
+#include <map>
+
+UnitGraph::UnitGraph(int BoxN)
+{
+    Reset(BoxN);
+}
+
+void UnitGraph::Reset(int BoxN)
+{
+    this->BoxN = BoxN;
+    N = BoxN * BoxN;
+    Cells = N * N;
+    classic = true;
+
+    units.clear();
+    regions.assign(Cells, 0);
+
+    for (int r = 0; r < N; r++)
+        for (int c = 0; c < N; c++)
+            units.push_back(r * N + c);
+
+    for (int c = 0; c < N; c++)
+        for (int r = 0; r < N; r++)
+            units.push_back(r * N + c);
+
+    for (int b = 0; b < N; b++)
+        for (int i = 0; i < BoxN; i++)
+            for (int j = 0; j < BoxN; j++)
+            {
+                int cell = (b / BoxN * BoxN + i) * N + (b % BoxN * BoxN + j);
+                units.push_back(cell);
+                regions[cell] = b;
+            }
+
+    Compile();
+}
+
+bool UnitGraph::SetRegions(const std::vector<int>& regions)
+{
+    if ((int)regions.size() != Cells)
+        return false;
+
+    std::vector<int> sizes(N, 0);
+    for (int region : regions)
+        if (region < 0 || region >= N || ++sizes[region] > N)
+            return false;
+
+    // the cells of a region in reading order.
+    for (int region = 0, k = 2 * N * N; region < N; region++)
+        for (int cell = 0; cell < Cells; cell++)
+            if (regions[cell] == region)
+                units[k++] = cell;
+
+    this->regions = regions;
+
+    // the regions may still be the boxes.
+    classic = true;
+    for (int cell = 0; cell < Cells && classic; cell++)
+        classic = regions[cell] == cell / N / BoxN * BoxN + cell % N / BoxN;
+
+    classic &= UnitCount() == 3 * N;
+
+    Compile();
+    return true;
+}
+
+bool UnitGraph::AddUnit(const std::vector<int>& cells)
+{
+    if ((int)cells.size() != N)
+        return false;
+
+    std::vector<int> sorted = cells;
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted[0] < 0 || sorted.back() >= Cells || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        return false;
+
+    units.insert(units.end(), cells.begin(), cells.end());
+    classic = false;
+
+    Compile();
+    return true;
+}
+
+void UnitGraph::AddDiagonals()
+{
+    std::vector<int> main, anti;
+    for (int i = 0; i < N; i++)
+    {
+        main.push_back(i * N + i);
+        anti.push_back(i * N + (N - 1 - i));
+    }
+
+    AddUnit(main);
+    AddUnit(anti);
+}
+
+void UnitGraph::AddWindows()
+{
+    std::vector<int> window;
+
+    // a window starts one cell after a box, and there is one cell between two windows.
+    for (int i = 0; i < BoxN - 1; i++)
+        for (int j = 0; j < BoxN - 1; j++)
+        {
+            int r = 1 + i * (BoxN + 1), c = 1 + j * (BoxN + 1);
+
+            window.clear();
+            for (int x = 0; x < BoxN; x++)
+                for (int y = 0; y < BoxN; y++)
+                    window.push_back((r + x) * N + (c + y));
+
+            AddUnit(window);
+        }
+}
+
+bool UnitGraph::Parse(const std::string& spec, int BoxN, UnitGraph& graph)
+{
+    graph.Reset(BoxN);
+
+    if (spec.empty())
+        return true;
+
+    for (size_t begin = 0; begin <= spec.size(); )
+    {
+        size_t end = std::min(spec.find('+', begin), spec.size());
+        std::string part = spec.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (part == "classic")
+            continue;
+        else if (part == "diagonal")
+            graph.AddDiagonals();
+        else if (part == "windoku")
+            graph.AddWindows();
+        else if (part.compare(0, 7, "jigsaw:") == 0)
+        {
+            // the characters become regions in the order they first appear.
+            std::map<char, int> ids;
+            std::vector<int> regions;
+
+            for (size_t i = 7; i < part.size(); i++)
+                regions.push_back(ids.insert({ part[i], (int)ids.size() }).first->second);
+
+            if (!graph.SetRegions(regions))
+                return false;
+        }
+        else
+            return false;
+    }
+
+    return true;
+}
+
+void UnitGraph::Compile()
+{
+    int count = UnitCount();
+
+    UnitStart.assign(Cells + 1, 0);
+    for (int u = 0; u < count; u++)
+        for (int i = 0; i < N; i++)
+            UnitStart[Unit(u)[i] + 1]++;
+
+    for (int cell = 0; cell < Cells; cell++)
+        UnitStart[cell + 1] += UnitStart[cell];
+
+    // the units are visited in order, so the units of every cell are ascending.
+    std::vector<int> next(UnitStart.begin(), UnitStart.end() - 1);
+    CellUnits.resize(UnitStart[Cells]);
+    for (int u = 0; u < count; u++)
+        for (int i = 0; i < N; i++)
+            CellUnits[next[Unit(u)[i]]++] = u;
+
+    // the scope of a classic cell is its row, its column and then its box, the order SudokuBoard always used.
+    std::vector<int> seen(Cells, -1);
+    ScopeStart.assign(1, 0);
+    PeerStart.assign(1, 0);
+    scope.clear();
+    peers.clear();
+
+    for (int cell = 0; cell < Cells; cell++)
+    {
+        for (const int* u = UnitsBegin(cell); u != UnitsEnd(cell); u++)
+            for (int i = 0; i < N; i++)
+            {
+                int other = Unit(*u)[i];
+                if (seen[other] == cell)
+                    continue;
+
+                seen[other] = cell;
+                scope.push_back(other);
+                if (other != cell)
+                    peers.push_back(other);
+            }
+
+        ScopeStart.push_back(scope.size());
+        PeerStart.push_back(peers.size());
+    }
+
+    scope.shrink_to_fit();
+    peers.shrink_to_fit();
+
+    // the families: every other unit sharing two or more cells with a unit goes into the first family of it
+    // whose segments it doesn't touch. on a classic board a box has its rows and its columns, a line its boxes.
+    families.clear();
+    std::vector<int> position(Cells, -1);
+
+    for (int a = 0; a < count; a++)
+    {
+        for (int i = 0; i < N; i++)
+            position[Unit(a)[i]] = i;
+
+        std::vector<int> others;
+        for (int i = 0; i < N; i++)
+            for (const int* u = UnitsBegin(Unit(a)[i]); u != UnitsEnd(Unit(a)[i]); u++)
+                if (*u != a)
+                    others.push_back(*u);
+
+        std::sort(others.begin(), others.end());
+        others.erase(std::unique(others.begin(), others.end()), others.end());
+
+        size_t first = families.size();
+
+        for (int b : others)
+        {
+            std::vector<int> inside, targets;
+            for (int i = 0; i < N; i++)
+            {
+                int cell = Unit(b)[i];
+                if (position[cell] != -1)
+                    inside.push_back(position[cell]);
+                else
+                    targets.push_back(cell);
+            }
+
+            // one cell is a single, all of them the same unit twice.
+            if (inside.size() < 2 || targets.empty())
+                continue;
+
+            size_t f = first;
+            for (; f < families.size(); f++)
+            {
+                bool free = true;
+                for (int i : inside)
+                    free &= families[f].segment[i] == -1;
+
+                if (free)
+                    break;
+            }
+
+            if (f == families.size())
+            {
+                families.push_back(Family());
+                families.back().unit = a;
+                families.back().segment.assign(N, -1);
+            }
+
+            Family& family = families[f];
+            for (int i : inside)
+                family.segment[i] = family.others.size();
+
+            family.others.push_back(b);
+            family.targets.push_back(targets);
+        }
+
+        // the cells in none of the segments are the last one.
+        for (size_t f = first; f < families.size(); f++)
+            for (int& segment : families[f].segment)
+                if (segment == -1)
+                    segment = families[f].others.size();
+
+        for (int i = 0; i < N; i++)
+            position[Unit(a)[i]] = -1;
+    }
+}
+
+size_t UnitGraph::MemoryUsage() const
+{
+    size_t bytes = sizeof(*this) + (units.capacity() + regions.capacity() + UnitStart.capacity() + CellUnits.capacity() +
+                   ScopeStart.capacity() + scope.capacity() + PeerStart.capacity() + peers.capacity()) * sizeof(int) +
+                   families.capacity() * sizeof(Family);
+
+    for (const Family& family : families)
+    {
+        bytes += (family.segment.capacity() + family.others.capacity()) * sizeof(int) + family.targets.capacity() * sizeof(std::vector<int>);
+        for (const std::vector<int>& targets : family.targets)
+            bytes += targets.capacity() * sizeof(int);
+    }
+
+    return bytes;
+}